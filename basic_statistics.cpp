@@ -11,6 +11,13 @@
 #include "student.h"
 #include "chisquare.h"
 #include "poisson.h"
+#include "quantile.h"
+#include "rolling.h"
+#include "ewma.h"
+#include "weighted.h"
+#include "regression.h"
+#include "correlation.h"
+#include "proportion.h"
 
 // Sample usage.
 void print(const std::string& s, const double x) { std::cout << " " << s << " " << x << std::endl; }
@@ -22,10 +29,31 @@ int main()
 
     print("mean:", mean(sample));
     print("median:", median(sample));
+    std::vector<double> quartiles = quantiles(sample, { .25, .5, .75 }); std::cout << " quartiles: " << quartiles[0] << " " << quartiles[1] << " " << quartiles[2] << std::endl;
     print("mode:", mode(sample));
     print("variance:", variance(sample));
     print("standard deviation:", standardDeviation(sample));
-    std::cout << "z-score:" << std::endl; std::for_each(sample.begin(), sample.end(), [&sample](double x) { std::cout << "  " << x << ": " << zScore(x, sample) << std::endl; });
+    std::cout << "z-score:" << std::endl; std::vector<double> z = zScores(sample); for (size_t i = 0; i < sample.size(); i++) { std::cout << "  " << sample[i] << ": " << z[i] << std::endl; }
+    Summary<double> summary = summarize(sample);
+    print("min:", summary.min);
+    print("max:", summary.max);
+    print("skewness:", summary.skewness);
+    print("kurtosis:", summary.kurtosis);
+    // Variance of two independently accumulated halves merged together.
+    RunningStats lo, hi; lo.push(sample.begin(), sample.begin() + sample.size() / 2); hi.push(sample.begin() + sample.size() / 2, sample.end()); lo.merge(hi);
+    print("merged variance:", lo.variance());
+    // Statistics of the last 3 samples, updated as each one arrives.
+    RollingStats window(3); RollingQuantiles windowq(3); for (double x : sample) { window.push(x); windowq.push(x); }
+    std::cout << " last 3 samples: mean " << window.mean() << ", sd " << window.standardDeviation() << ", median " << windowq.median() << std::endl;
+    // Trend (least squares slope against sample index) of the last 3 samples, updated per sample.
+    RollingRegression trend(3); for (size_t i = 0; i < sample.size(); i++) trend.push(double(i), sample[i]);
+    std::cout << " last 3 samples trend: slope " << trend.slope() << ", r " << trend.r() << std::endl;
+    // Exponentially-weighted statistics, weight halves every 2 samples.
+    EWDecay decay(2.); EWStats ew; for (double x : sample) ew.push(x, decay);
+    std::cout << " exponentially-weighted: mean " << ew.mean() << ", sd " << ew.standardDeviation() << ", z-score of 6: " << ew.zScore(6.) << std::endl;
+    // Weighted statistics, each sample counted the given number of times.
+    std::vector<double> counts = { 1., 2., 1., 1., 3., 2. };
+    std::cout << " weighted: mean " << weightedMean(sample, counts) << ", sd " << weightedStandardDeviation(sample, counts) << ", median " << weightedMedian(sample, counts) << std::endl;
 
 
     // Binomial Probabilities: P(X=k) = dbinom(#success, #trials, prob. success) and P(X<=k) = pbinom(#success, #trials, #prob. success)
@@ -36,6 +64,8 @@ int main()
         print("Exactly 7 shots:", dBinom(7, 10, 0.44));
         // If he attempts ten 3-point shots, find probability he makes at least 7. P(x>=7) = P(x=7) + P(x=8) + P(x=9) + P(x=10).
         print("At least 7 shots:", dBinom(7, 10, 0.44) + dBinom(8, 10, 0.44) + dBinom(9, 10, 0.44) + dBinom(10, 10, 0.44));
+        // Quartiles of the number of shots he makes, qbinom(c(.25, .5, .75), 10, 0.44). = 3 4 5
+        std::vector<double> shots = qBinom({ .25, .5, .75 }, 10, 0.44); std::cout << " Quartiles of shots made: " << shots[0] << " " << shots[1] << " " << shots[2] << std::endl;
 
         // 79% of adults need glasses. If 20 adults are randomly 
         // selected, find probability that 16 need glasses. = 0.217
@@ -45,6 +75,10 @@ int main()
         // selected. Find probability more than 17 drink coffee. = 0.237
         // P(X>17) = P(X=18) + P(X=19) + ... P(X=25), as: dBinomial(18, 25, 0.63) + ... dBinomial(25, 25, 0.63)
         print("More than 17 drink coffee:", 1. - pBinom(17, 25, 0.63));
+        // Every count at once, dbinom(0:25, 25, 0.63) and pbinom(0:25, 25, 0.63, lower.tail = FALSE): the most 
+        // likely number of coffee drinkers, and more than 17 again from the upper tail. = 16 and 0.237
+        std::vector<double> pmf(26), upper(26); binomPMF(25, 0.63, pmf); binomCDF(25, 0.63, upper, false);
+        std::cout << " Most likely coffee drinkers: " << std::max_element(pmf.begin(), pmf.end()) - pmf.begin() << ", more than 17: " << upper[17] << std::endl;
 
         // Medical procedure produces side effects in 25% of patients. 60 people undergo the 
         // procedure. What is probability that fewer than 20 experience side effect? =0.908
@@ -68,6 +102,9 @@ int main()
         // McDonald's game produces 25% instant winners. Out of 530 
         // attempts, what is probability of only 108 winners? =0.007
         print("McDonald's winners:", pBinom(108, 530, 0.25));
+
+        // Log of the number of ways to choose 500 of 1000 items, lchoose(1000, 500), from the shared log factorial table (1000! overflows a double). = 689.467
+        print("log(choose(1000, 500)):", logChoose(1000, 500));
     }
 
     // Normal Distribution Probabilities (percent, proportion): pnorm(z) x->z->area, qnorm(left area) area->z->x
@@ -76,6 +113,8 @@ int main()
         // Customers waiting time is normally distributed with mean of 2.58 minutes and standard deviation 
         // of 0.76. Find probability a random customer waits more than 4 minutes. = 0.969
         print("Waiting more than 4 mins:", pNorm(4, 2.58, 0.76));
+        // The same from the table-driven tier, for latency-bound callers (absolute error below 1e-13).
+        print("Waiting more than 4 mins, Table tier:", pNorm<Precision::Table>(4, 2.58, 0.76));
 
         // Cholesterol levels are normally distributed with mean of 201 and standard 
         // deviation of 46. What cholesterol level separates the lowest 22%? = 165.488
@@ -83,7 +122,7 @@ int main()
 
         // Survey of students study hours are normally distributed with a mean of 25 hours per week 
         // and standard deviation of 7. What proportion study more than 40 hours per week? = 0.016
-        print("Study more than 40 hours:", 1. - pNorm(40, 25, 7));
+        print("Study more than 40 hours:", pNorm(40, 25, 7, false));
 
         // Men's height normally distributed with mean of 68.6" and standard deviation 
         // of 2.8". Find height that separates the tallest 3% of men. = 73.867
@@ -100,6 +139,12 @@ int main()
         // Scores on a test were normally distributed with a mean of 75 and 
         // standard deviation of 8. Find 85th percentile of exams. = 83.288
         print("85th percentile of exams:", qNorm(0.85, 75, 8));
+        // The same percentile from the Exact precision tier (full double precision), and how far the Fast tier
+        // (Acklam's approximation, relative error about 1e-9) is from it.
+        double exact = qNorm<Precision::Exact>(0.85, 75, 8); std::cout << " 85th percentile of exams, Exact: " << exact << ", Fast - Exact: " << qNorm<Precision::Fast>(0.85, 75, 8) - exact << std::endl;
+
+        // Same exams, every quartile at once (batch qNorm). = 69.604 75 80.396
+        std::vector<double> exams = { .25, .5, .75 }, scores(3); qNorm(exams, scores, 75, 8); std::cout << " Exam quartiles: " << scores[0] << " " << scores[1] << " " << scores[2] << std::endl;
     }
 
     // Central Limit Theorem (means), n>=30 results in averages making approx. normal distribution with mu=mu, sigma=sigma/sqrt(n)
@@ -112,7 +157,7 @@ int main()
 
         // Typing speed is approx. normal, with mean speed of 45wpm and standard deviation of 10wpm. 
         // What is probability that random sample of 12 people have mean typing speed >40wpm? = 0.958
-        print("12 people type greater than 40 wpm:", 1. - pNorm(40, 45, qSigmaCLT(12, 10)));
+        print("12 people type greater than 40 wpm:", pNorm(40, 45, qSigmaCLT(12, 10), false));
 
         // Mean commute is 16 miles, with standard deviation of 8. Sample 75 commuters, 
         // there is 94% probability that mean commute is between what 2 distances? = 14.262 and 17.738
@@ -133,7 +178,7 @@ int main()
     {
         // 63% of adults drink coffee daily. Random sample of 250 adults is selected. 
         // Find probability that more than 67% of sampled drink coffee daily. = 0.095
-        print("Probability 67% of 250 drink coffee:", 1. - pNorm(0.67, 0.63, pSigmaCLT(250, 0.63)));
+        print("Probability 67% of 250 drink coffee:", pNorm(0.67, 0.63, pSigmaCLT(250, 0.63), false));
 
         // 68% of graduates have loan debt. From random sample of 85 grads, 
         // find probability that between 65 and 80% are in debt. = 0.713
@@ -152,7 +197,7 @@ int main()
 
         // 18% of commercials on TV are local advertisers. Of sample of 120 
         // commercials, what is probability that more than 20% are local? 
-        print("Probability more than 20 local ads:", 1. - pNorm(0.20, 0.18, pSigmaCLT(120, 0.18)));
+        print("Probability more than 20 local ads:", pNorm(0.20, 0.18, pSigmaCLT(120, 0.18), false));
 
         // Lifetime of a tire is normally distriburted with mean of 40,000 miles and standard 
         // deviation of 5,000. Between what two lifetimes do 80% of lifetimes fall? 
@@ -208,7 +253,7 @@ int main()
         {
             // A newspaper wants to predict outcome of election by estimating proportion voters supporting particular 
             // candidate. What sample size is needed to yield an estimate within 3% with 97% CI? =1309
-            double phat = 0.5, E = 0.03; printCI("97", phat, round(proportionN(E, qNorm(.97 + (1 - .97) / 2), phat) + .5));
+            constexpr double z97 = qNorm(.97 + (1 - .97) / 2); double phat = 0.5, E = 0.03; printCI("97", phat, round(proportionN(E, z97, phat) + .5));
         }
     }
 
@@ -273,6 +318,14 @@ int main()
             // State conclusion in sentence.
             std::cout << " At 0.03 level of significance, there is not enough evidence to conclude that Specific college students daily newspaper readers differs from 15%.\n";
         }
+        {
+            // Mendel crossed pea plants and 682 of 925 offspring had purple flowers. Does this differ from the 
+            // expected 3:1 ratio (p=0.75)? Exact binomial test, binom.test(682, 925, p = 0.75). p-value =0.382
+            double p = binomTest(682, 925, 0.75); print("exact p-value:", p);
+            std::cout << " We ";  DecideHypothesis(p, 0.05);
+            // Clopper-Pearson 95% CI for the proportion of purple flowers. =(0.708 to 0.765)
+            std::pair<double, double> ci = proportionCI(682, 925); std::cout << " 95% CI: " << ci.first << " to " << ci.second << std::endl;
+        }
     }
 
 
@@ -565,16 +618,18 @@ int main()
             // cor.test(x, y): cor.test(absences, grades)
             std::vector<double> absences = { 8, 2, 5, 12,15, 9, 6 };
             std::vector<double> grades = { 82, 92, 90, 51, 43, 70, 82 };
-            std::pair<double, double> fit = lsq(absences, grades);
-            std::cout << " m: " << fit.first << ", b: " << fit.second << "\n";
-            double r = R(absences, grades);  print("correlation coefficeint r:", r);
+            // One pass gives the fit, r and the slope test: summary(lm(grades~absences))
+            Bivariate fit = bivariate(absences, grades);
+            std::cout << " m: " << fit.slope() << ", b: " << fit.intercept() << "\n";
+            std::cout << " standard errors: m " << fit.slopeStandardError() << ", b " << fit.interceptStandardError() << ", residual " << fit.residualStandardError() << "\n";
+            double r = fit.r();  print("correlation coefficeint r:", r);
             print("coefficeint of determination r^2:", pow(r, 2.));
             std::cout << " 92.4% of variation in grades (y) can be explained by variation in absences (x).\n";
             // State null and alternative hypothesis: H0 = "rho = 0", H1 = "rho != 0".
             // Find critical value, 2-tailed! =7.823
             unsigned DoF = 5 /* n - 2 */; double t = r * sqrt(DoF) / sqrt(1. - pow(r, 2.)); print("t:", t);
             // Find p-value. =0.001
-            double p = (1. - pt(7.8233, DoF)) * 2.; print("p:", p);
+            double p = fit.slopePValue(); print("p:", p);
             // Reject or accept H0? =reject H0
             std::cout << " We ";  DecideHypothesis(p, 0.02);
             // State conclusion in sentence.
@@ -600,6 +655,23 @@ int main()
             // State conclusion in sentence.
             std::cout << " At 0.05 level of significance, there is enough evidence to conclude a linear correlation.\n";
         }
+        {
+            // Multiple regression, grades on absences and hours of study: summary(lm(grades~absences+study))
+            std::vector<double> absences = { 8, 2, 5, 12, 15, 9, 6 };
+            std::vector<double> study = { 5, 9, 6, 2, 1, 4, 7 };
+            std::vector<double> grades = { 82, 92, 90, 51, 43, 70, 82 };
+            RegressionFit fit = regress({ absences, study }, grades);
+            const char* names[] = { "(Intercept)", "absences", "study" };
+            for (size_t j = 0; j < fit.coefficients.size(); j++)
+                std::cout << " " << names[j] << ": " << fit.coefficients[j] << ", se " << fit.standardErrors[j] << ", t " << fit.tValues[j] << ", p " << fit.pValues[j] << "\n";
+            print("R^2:", fit.rSquared);
+            // All pairwise correlations at once: cor(cbind(absences, study, grades))
+            std::vector<double> r = correlationMatrix({ absences, study, grades });
+            std::cout << " cor(absences, study) " << r[1] << ", cor(absences, grades) " << r[2] << ", cor(study, grades) " << r[5] << "\n";
+            // Rank correlations: cor.test(absences, grades, method = "spearman" / "kendall", exact = FALSE)
+            CorrelationTest rho = spearman(absences, grades), tau = kendall(absences, grades);
+            std::cout << " spearman rho " << rho.r << " (p " << rho.pValue << "), kendall tau " << tau.r << " (p " << tau.pValue << ")\n";
+        }
     }
 
 
@@ -609,6 +681,8 @@ int main()
         // Number of visits to a web page follows a Poisson distribution with mean 15 visits per hour.
         // What is probability of getting 10 or less visits per hour, P(X≤10)? =0.118
         print("10 or less web visits per hour:", pPois(10, 15));
+        // Quartiles of the visits per hour, qpois(c(.25, .5, .75), 15). = 12 15 18
+        std::vector<double> visits = qPois({ .25, .5, .75 }, 15); std::cout << " Quartiles of web visits per hour: " << visits[0] << " " << visits[1] << " " << visits[2] << std::endl;
         // Equivalent to...
         //{ 
           //double p = 0.; 
@@ -0,0 +1,223 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+// Our stat package includes.
+#include "common.h"
+#include "normal.h"
+#include "binomial.h"
+
+// Timing and accuracy of the normal precision tiers and of pBinom. Results go to the console and to bench_output.txt.
+// Times are per call, a loop over 64K inputs on one core (z uniform in [-8, 8], p uniform in (0, 1)).
+// Errors are the largest seen on a dense scan (|z| <= 38, p in [1e-300, 1 - 1e-16]) against a long
+// double reference (erfcl and expl); relative errors leave out subnormal results.
+
+static std::ofstream benchFile;
+static volatile double benchSink;
+
+void report(const std::string& s)
+{
+    std::cout << s << std::endl;
+    benchFile << s << std::endl;
+}
+
+// Nanoseconds per call of f over the inputs, best of 5 runs.
+template<typename Fn>
+double nsPerCall(const std::vector<double>& in, Fn f)
+{
+    double best = INFINITY;
+
+    for (int run = 0; run < 5; run++)
+    {
+        double s = 0.;
+        auto t0 = std::chrono::steady_clock::now();
+        for (double x : in)
+            s += f(x);
+        auto t1 = std::chrono::steady_clock::now();
+        benchSink = s;
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / in.size());
+    }
+
+    return best;
+}
+
+// Phi(z) in long double.
+long double pNormRef(const long double z) { return erfcl(-z / sqrtl(2.L)) / 2.L; }
+
+long double dNormRef(const long double z) { return expl(-z * z / 2.L) / sqrtl(2.L * acosl(-1.L)); }
+
+// z with Phi(z) = p by Newton steps in long double from a double start.
+long double qNormRef(const double p, const double start)
+{
+    long double z = start;
+
+    for (int i = 0; i < 8; i++)
+        z -= (pNormRef(z) - p) / dNormRef(z);
+
+    return z;
+}
+
+struct Errors
+{
+    double abs = 0., rel = 0.;
+
+    void add(const long double value, const long double ref)
+    {
+        double e = double(fabsl(value - ref));
+        abs = std::max(abs, e);
+        if (fabsl(ref) >= DBL_MIN)
+            rel = std::max(rel, double(e / fabsl(ref)));
+    }
+};
+
+template<Precision P>
+void benchNormal(const char* name, const std::vector<double>& zs, const std::vector<double>& ps)
+{
+    Errors pe, qe, de;
+
+    for (double z : zs)
+    {
+        pe.add(pNorm<P>(z), pNormRef(z));
+        de.add(dNorm<P>(z), dNormRef(z));
+    }
+    for (double p : ps)
+    {
+        double z = qNorm<P>(p);
+        qe.add(z, qNormRef(p, z));
+    }
+
+    std::vector<double> zt(1 << 16), pt(1 << 16);
+    for (size_t i = 0; i < zt.size(); i++)
+    {
+        // Golden ratio sequence, spread evenly without a pattern the branch predictor could learn.
+        double u = fmod(0.5 + i * 0.6180339887498949, 1.);
+        zt[i] = 16. * u - 8.;
+        pt[i] = u;
+    }
+
+    std::ostringstream s;
+    s.precision(2);
+    s << " " << name << "\tpNorm " << std::fixed << nsPerCall(zt, [](double z) { return pNorm<P>(z); }) << " ns "
+        << std::scientific << pe.abs << " abs " << pe.rel << " rel"
+        << "\tqNorm " << std::fixed << nsPerCall(pt, [](double p) { return qNorm<P>(p); }) << " ns "
+        << std::scientific << qe.rel << " rel"
+        << "\tdNorm " << std::fixed << nsPerCall(zt, [](double z) { return dNorm<P>(z); }) << " ns "
+        << std::scientific << de.rel << " rel";
+    report(s.str());
+}
+
+void benchNormalTiers()
+{
+    // z on a grid of |z| <= 38, p log spaced over [1e-300, 1/2] and mirrored down to 1 - 1e-16.
+    std::vector<double> zs, ps;
+
+    for (double z = -38.; z <= 38.; z += 1. / 1024.)
+        zs.push_back(z + 1e-4 * sin(z * 1e3));
+    for (double e = -300.; e < log10(0.5); e += 1. / 512.)
+    {
+        double p = pow(10., e);
+        ps.push_back(p);
+        if (p >= 1e-16)
+            ps.push_back(1. - p);
+    }
+
+    report("Normal distribution, precision tiers (time per call, largest error):");
+    benchNormal<Precision::Table>("Table", zs, ps);
+    benchNormal<Precision::Fast>("Fast", zs, ps);
+    benchNormal<Precision::Standard>("Standard", zs, ps);
+    benchNormal<Precision::Exact>("Exact", zs, ps);
+}
+
+// The O(k) summation pBinom replaced by the incomplete beta, kept as the timing reference. It sums the
+// terms k = 1 ... q and leaves out k = 0, which is why its results are not used for the error.
+double pBinomLoop(const unsigned k, const unsigned n, const double p)
+{
+    double cdf = 0.;
+    double b = 0.;
+
+    for (unsigned _k = 1; _k <= (unsigned)k; _k++)
+    {
+        double log_pmf_k = 0.;
+
+        b += +log(n - _k + 1.) - log(_k);
+        log_pmf_k = b + _k * log(p) + (n - _k) * log(1. - p);
+        cdf += exp(log_pmf_k);
+    }
+
+    return cdf;
+}
+
+// Both tails of Binomial(n, p) at every k in long double: the pmf by its recurrence outward from the
+// mode (relative to the mode, so nothing underflows), summed and normalized by the total.
+void binomTailsRef(const unsigned n, const double p, std::vector<long double>& lower, std::vector<long double>& upper)
+{
+    std::vector<long double> f(n + 1);
+    long double r = (long double)p / (1.L - p), total = 0.L;
+    unsigned m = unsigned(std::min(floor((n + 1.) * p), double(n)));
+
+    f[m] = 1.L;
+    for (unsigned k = m; k < n; k++)
+        f[k + 1] = f[k] * (n - k) / (k + 1) * r;
+    for (unsigned k = m; k > 0; k--)
+        f[k - 1] = f[k] * k / (n - k + 1) / r;
+
+    lower.assign(n + 1, 0.L);
+    upper.assign(n + 1, 0.L);
+    for (unsigned k = 0; k <= n; k++)
+        total = lower[k] = total + f[k];
+    for (unsigned k = n; k > 0; k--)
+        upper[k - 1] = upper[k] + f[k];
+    for (unsigned k = 0; k <= n; k++)
+    {
+        lower[k] /= total;
+        upper[k] /= total;
+    }
+}
+
+void benchBinomial()
+{
+    report("Binomial distribution function, pBinom (incomplete beta) against the O(k) loop:");
+
+    for (unsigned n : { 20u, 200u, 2000u, 100000u, 1000000u })
+    {
+        Errors lower, upper;
+
+        for (double p : { 0.001, 0.01, 0.1, 0.3, 0.5, 0.7, 0.99 })
+        {
+            std::vector<long double> lo, up;
+            binomTailsRef(n, p, lo, up);
+
+            for (unsigned k = 0; k < n; k += std::max(1u, n / 4096))
+            {
+                lower.add(pBinom(k, n, p), lo[k]);
+                upper.add(pBinom(k, n, p, false), up[k]);
+            }
+        }
+
+        // Time at k = n p, p = 0.3, where the loop sums 0.3 n terms.
+        std::vector<double> ks(n < 100000 ? 4096 : 64);
+        for (size_t i = 0; i < ks.size(); i++)
+            ks[i] = std::max(0., floor(0.3 * n) + double(i % 16) - 8.);
+
+        std::ostringstream s;
+        s.precision(2);
+        s << " n = " << n << "	pBinom " << std::fixed << nsPerCall(ks, [n](double k) { return pBinom(unsigned(k), n, 0.3); }) << " ns"
+            << "	loop " << nsPerCall(ks, [n](double k) { return pBinomLoop(unsigned(k), n, 0.3); }) << " ns"
+            << std::scientific << "	largest relative error " << lower.rel << " lower tail, " << upper.rel << " upper tail";
+        report(s.str());
+    }
+}
+
+int main()
+{
+    benchFile.open("bench_output.txt");
+
+    benchNormalTiers();
+    benchBinomial();
+
+    return 0;
+}
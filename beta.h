@@ -0,0 +1,282 @@
+#ifndef BETA_H
+#define BETA_H
+
+#include "common.h"
+#include "erf.h"
+
+/*
+  The Beta Distribution
+  Distribution function of the beta distribution, the regularized incomplete beta function
+     I_x(a, b) = 1 / B(a, b) integral[0, x] t^(a - 1) (1 - t)^(b - 1) dt
+  It is also the binomial distribution function, P(X <= k) = 1 - I_p(k + 1, n - k).
+  The cost does not grow with a and b: away from the mean the continued fraction converges in a few
+  dozen terms, and near the mean of large a and b (where the fraction would need O(sqrt(a + b)) terms)
+  the asymptotic expansion is used instead (DiDonato and Morris, TOMS 708, BFRAC and BASYM). Shapes
+  below 1 use Lentz's form of the continued fraction.
+  Usage:
+     pbeta(q, shape1, shape2, lower.tail = TRUE, log.p = FALSE)
+     qbeta(p, shape1, shape2, lower.tail = TRUE)
+*/
+
+// log of the binomial density of a successes and b failures in a + b trials, for real a, b > 0
+// (q = 1 - p). Loader's saddle point form as R's dbinom_raw: the stirlerr and bd0 terms are small,
+// unlike lgamma differences that cancel for large a + b.
+static double logDBinomRaw(const double a, const double b, const double p, const double q)
+{
+    double n = a + b;
+    double lc = stirlerr(n) - stirlerr(a) - stirlerr(b) - bd0(a, n * p) - bd0(b, n * q);
+
+    return lc - 0.5 * log(M_2PI * (a / n) * b);
+}
+
+// log(I_x(a, b)) by the continued fraction of TOMS 708 (BFRAC), lambda = (a + b) y - b >= 0. Its
+// terms are built from lambda, where forming 1 - (a + b) x / (a + 1) from x alone would cancel for
+// large a + b. x^a y^b / B(a, b) is ab / (a + b) times the binomial density of a in a + b trials.
+static double logBetaFraction(const double a, const double b, const double x, const double y, const double lambda)
+{
+    double c = lambda + 1., c0 = b / a, c1 = 1. / a + 1., yp1 = y + 1.;
+    double n = 0., p = 1., s = a + 1., an = 0., bn = 1., anp1 = 1., bnp1 = c / c1, r = c1 / c;
+
+    do
+    {
+        n += 1.;
+        double t = n / a, w = n * (b - n) * x, e = a / s;
+        double alpha = p * (p + c0) * e * e * (w * x);
+        e = (t + 1.) / (c1 + t + t);
+        double beta = n + w / s + e * (c + n * yp1);
+        p = t + 1.;
+        s += 2.;
+
+        t = alpha * an + beta * anp1;
+        an = anp1;
+        anp1 = t;
+        t = alpha * bn + beta * bnp1;
+        bn = bnp1;
+        bnp1 = t;
+
+        double r0 = r;
+        r = anp1 / bnp1;
+        if (fabs(r - r0) <= 1e-15 * r)
+            break;
+
+        // Rescale so the recurrences cannot overflow.
+        an /= bnp1;
+        bn /= bnp1;
+        anp1 = r;
+        bnp1 = 1.;
+    } while (n < 10000.);
+
+    return log(a * b / (a + b)) + logDBinomRaw(a, b, x, y) + log(r);
+}
+
+// log(I_x(a, b)) for large a and b near the mean, lambda = (a + b) y - b >= 0 (x at or below the mean).
+// DiDonato and Morris, ACM TOMS 18 (1992), BASYM: a uniform expansion around the normal approximation
+// erfc(sqrt(f)) / 2.
+static double logBetaAsymptotic(const double a, const double b, const double lambda)
+{
+    const int terms = 20;
+    const double e0 = 1.12837916709551;    // 2 / sqrt(pi)
+    const double e1 = 0.353553390593274;   // 2^(-3/2)
+    const double ln_e0 = 0.120782237635245;
+    double a0[terms + 1], b0[terms + 1], c[terms + 1], d[terms + 1];
+
+    double f = -(a * log1pmx(-lambda / a) + b * log1pmx(lambda / b));
+    double z0 = sqrt(f), z = z0 / e1 * 0.5, z2 = f + f;
+    double h, r0, r1, w0;
+
+    if (a < b)
+    {
+        h = a / b;
+        r0 = 1. / (h + 1.);
+        r1 = (b - a) / b;
+        w0 = 1. / sqrt(a * (h + 1.));
+    }
+    else
+    {
+        h = b / a;
+        r0 = 1. / (h + 1.);
+        r1 = (b - a) / a;
+        w0 = 1. / sqrt(b * (h + 1.));
+    }
+
+    a0[0] = r1 * 2. / 3.;
+    c[0] = a0[0] * -0.5;
+    d[0] = -c[0];
+
+    double j0 = 0.5 / e0 * _erfcx(z0), j1 = e1;
+    double sum = j0 + d[0] * w0 * j1;
+    double s = 1., h2 = h * h, hn = 1., w = w0, znm1 = z, zn = z2;
+
+    for (int n = 2; n <= terms; n += 2)
+    {
+        hn *= h2;
+        a0[n - 1] = r0 * 2. * (h * hn + 1.) / (n + 2.);
+        s += hn;
+        a0[n] = r1 * 2. * s / (n + 3.);
+
+        for (int i = n; i <= n + 1; i++)
+        {
+            double r = (i + 1.) * -0.5;
+
+            b0[0] = r * a0[0];
+            for (int m = 2; m <= i; m++)
+            {
+                double bsum = 0.;
+                for (int j = 1; j < m; j++)
+                    bsum += (j * r - (m - j)) * a0[j - 1] * b0[m - j - 1];
+                b0[m - 1] = r * a0[m - 1] + bsum / m;
+            }
+            c[i - 1] = b0[i - 1] / (i + 1.);
+
+            double dsum = 0.;
+            for (int j = 1; j < i; j++)
+                dsum += d[i - j - 1] * c[j - 1];
+            d[i - 1] = -(dsum + c[i - 1]);
+        }
+
+        j0 = e1 * znm1 + (n - 1.) * j0;
+        j1 = e1 * zn + n * j1;
+        znm1 *= z2;
+        zn *= z2;
+        w *= w0;
+        double t0 = d[n - 1] * w * j0;
+        w *= w0;
+        double t1 = d[n] * w * j1;
+        sum += t0 + t1;
+        if (fabs(t0) + fabs(t1) <= 1e-15 * sum)
+            break;
+    }
+
+    // stirlerr(a) is TOMS 708's del(a), so this is its bcorr(a, b).
+    double bcorr = stirlerr(a) + stirlerr(b) - stirlerr(a + b);
+
+    return ln_e0 - f - bcorr + log(sum);
+}
+
+// I_x(a, b) with y = 1 - x given separately (it may carry digits 1 - x would lose). The tail on the
+// side of x away from the mean is computed directly, the other one as its complement.
+double pBetaRaw(const double x, const double y, const double a, const double b, const bool lower_tail = true, const bool log_p = false)
+{
+    if (!(x > 0.) || !(y > 0.))
+    {
+        bool zero = ((x > 0.) != lower_tail);
+        return log_p ? (zero ? ML_NEGINF : 0.) : (zero ? 0. : 1.);
+    }
+
+    // lambda = (a + b) y - b = a - (a + b) x, from y when the mean is above 1/2 so it does not cancel.
+    // Swap to the other tail, I_y(b, a), when x is above the mean.
+    double lambda = (a > b) ? (a + b) * y - b : a - (a + b) * x;
+    bool swapped = (lambda < 0.);
+    double a0 = swapped ? b : a, b0 = swapped ? a : b, x0 = swapped ? y : x, y0 = swapped ? x : y, lt;
+
+    lambda = fabs(lambda);
+    if (fmin2(a, b) > 100. && lambda <= 0.03 * fmin2(a, b))
+        lt = logBetaAsymptotic(a0, b0, lambda);
+    else if (fmin2(a, b) >= 1.)
+        lt = logBetaFraction(a0, b0, x0, y0, lambda);
+    else
+        lt = log(b0 / (a0 + b0)) + logDBinomRaw(a0, b0, x0, y0) + log(cxBetaCF(a0, b0, x0));
+
+    // lt is the log of the lower tail when not swapped, of the upper tail when swapped.
+    if (lower_tail != swapped)
+        return log_p ? lt : exp(lt);
+
+    return log_p ? log1p(-exp(lt)) : -expm1(lt);
+}
+
+// The beta distribution function, pbeta(q, shape1, shape2, lower.tail, log.p).
+double pBeta(const double x, const double a, const double b, const bool lower_tail = true, const bool log_p = false)
+{
+#ifdef IEEE_754
+    if (isnan(x) || isnan(a) || isnan(b))
+        return x + a + b;
+#endif
+
+    if (!(a > 0.) || !(b > 0.))
+        return NAN;
+
+    return pBetaRaw(x, 1. - x, a, b, lower_tail, log_p);
+}
+
+// The beta quantile function, qbeta(p, shape1, shape2, lower.tail). It solves for the smaller tail
+// (an upper tail of Beta(a, b) at x is the lower tail of Beta(b, a) at 1 - x), starting from the AS 109
+// approximation (Cran, Martin and Thomas, 1977). Newton steps on log I_x(a, b) against log x follow
+// (nearly linear in the lower tail, where I_x ~ x^a); a step that leaves the bracket of the root
+// bisects it instead.
+double qBeta(const double p, const double a, const double b, const bool lower_tail = true)
+{
+#ifdef IEEE_754
+    if (isnan(p) || isnan(a) || isnan(b))
+        return p + a + b;
+#endif
+
+    if (!(a > 0.) || !(b > 0.) || p < 0. || p > 1.)
+        return NAN;
+
+    // Lower tail t <= 1/2 of Beta(pp, qq); the quantile is 1 - x when the shapes are swapped.
+    bool swap = ((p > 0.5) == lower_tail);
+    double t = (p > 0.5) ? 1. - p : p, pp = swap ? b : a, qq = swap ? a : b;
+
+    if (t == 0.)
+        return swap ? 1. : 0.;
+
+    // AS 109 starting value.
+    double logbeta = lgamma(pp) + lgamma(qq) - lgamma(pp + qq);
+    double r = sqrt(-2. * log(t));
+    double y = r - (2.30753 + 0.27061 * r) / (1. + (0.99229 + 0.04481 * r) * r), x;
+
+    if (pp > 1. && qq > 1.)
+    {
+        r = (y * y - 3.) / 6.;
+        double s = 1. / (pp + pp - 1.), u = 1. / (qq + qq - 1.), h = 2. / (s + u);
+        double w = y * sqrt(h + r) / h - (u - s) * (r + 5. / 6. - 2. / (3. * h));
+        x = pp / (pp + qq * exp(w + w));
+    }
+    else
+    {
+        r = qq + qq;
+        double u = 1. / (9. * qq);
+        u = r * pow(1. - u + y * sqrt(u), 3.);
+        if (u <= 0.)
+            x = -expm1((log1p(-t) + log(qq) + logbeta) / qq);
+        else
+        {
+            u = (4. * pp + r - 2.) / u;
+            x = (u <= 1.) ? exp((log(t * pp) + logbeta) / pp) : 1. - 2. / (u + 1.);
+        }
+    }
+
+    double lo = 0., hi = 1., lt = log(t);
+    if (!(x > 0. && x < 1.))
+        x = 0.5;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        double li = pBetaRaw(x, 1. - x, pp, qq, true, true), g = li - lt;
+
+        if (g == 0.)
+            break;
+        if (g > 0.)
+            hi = x;
+        else
+            lo = x;
+
+        // Newton step in log x: d log I / d log x = x f(x) / I_x, x f(x) = ab / (a + b) dbinom(a; a + b, x) / (1 - x).
+        double lxf = log(pp * qq / (pp + qq)) + logDBinomRaw(pp, qq, x, 1. - x) - log1p(-x);
+        double step = g * exp(li - lxf), next = x * exp(-step);
+
+        if (fabs(step) <= 1e-15)
+        {
+            x = next;
+            break;
+        }
+
+        x = (next > lo && next < hi) ? next : (lo + hi) / 2.;
+        if (hi - lo <= 1e-15 * x)
+            break;
+    }
+
+    return swap ? 1. - x : x;
+}
+
+#endif
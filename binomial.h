@@ -1,7 +1,9 @@
 ﻿#ifndef BINOMIAL_H
 #define BINOMIAL_H
 
+#include <span>
 #include "common.h"
+#include "beta.h"
 
 /*
    The Binomial Distribution
@@ -20,6 +22,8 @@
    Usage:
      dbinom(x, size, prob, log = FALSE)
      pbinom(q, size, prob, lower.tail = TRUE, log.p = FALSE)
+     qbinom(p, size, prob)   p may be a std::vector, answered in one sorted sweep
+     binomPMF(size, prob, out), binomCDF(size, prob, out, lower.tail = TRUE)   the whole support 0 ... size
    
    Arguments:
      x, q=quantiles
@@ -28,10 +32,26 @@
      k=number of trials (zero or more).
 */
 
-// Binomial PMF(p, n,k) = n!/(k!*(n-k)!) p^k (1-p)^(n-k)
+// log(choose(n, k)), three lookups in the shared log factorial table.
 static double logChoose(const unsigned n, const unsigned k)
 {
-    return std::lgamma(double(n + 1)) - std::lgamma(double(k + 1)) - std::lgamma(double(n - k + 1));
+    return logFactorial(n) - logFactorial(k) - logFactorial(n - k);
+}
+
+// log P(X = k) for 0 <= k <= n (q = 1 - p), in Loader's saddle point form so it stays accurate for large n.
+static double binomLogPmf(const double k, const double n, const double p, const double q)
+{
+    if (k == 0.)
+        return n * log1p(-p);
+    if (k == n)
+        return n * log(p);
+
+    return logDBinomRaw(k, n - k, p, q);
+}
+
+static double binomPmf(const double k, const double n, const double p, const double q)
+{
+    return exp(binomLogPmf(k, n, p, q));
 }
 
 // Binomial PMF(p, n,k) = n!/(k!*(n-k)!) p^k (1-p)^(n-k)
@@ -39,31 +59,201 @@ double dBinom(const unsigned k, const unsigned n, const double p)
 {
     //double nCk = (factorial((unsigned)n) / (factorial((unsigned)k) * factorial((unsigned)(n - k))));
     //return (nCk * pow(p, k) * pow(1.0 - p, n - k));
-    double lgr = logChoose(n, k) + double(k) * std::log(p) + double(n - k) * std::log(1 - p);
+    if (k > n)
+        return 0.;
+    if (p == 0. || p == 1.)
+        return (k == ((p == 0.) ? 0 : n)) ? 1. : 0.;
+
+    if (n <= LOG_FACTORIAL_DIRECT_N)
+    {
+        double lp = double(k) * std::log(p), lq = double(n - k) * std::log1p(-p);
+
+        if (logFactorial(n) + fabs(lp) + fabs(lq) <= LOG_FACTORIAL_DIRECT)
+            return std::exp(logChoose(n, k) + lp + lq);
+    }
+
+    return binomPmf(k, n, p, 1. - p);
+}
+
+// Binomial CDF, P(X <= k) = 1 - I_p(k + 1, n - k) (regularized incomplete beta).
+// The cost does not depend on n or k, where summing the terms was O(k).
+double pBinom(const unsigned k, const unsigned n, const double p, const bool lower_tail = true, const bool log_p = false)
+{
+    if (isnan(p) || p < 0. || p > 1.)
+        return NAN;
+    if (k >= n || p == 0.)
+        return log_p ? (lower_tail ? 0. : ML_NEGINF) : (lower_tail ? 1. : 0.);
+
+    return pBetaRaw(p, 1. - p, k + 1., double(n - k), !lower_tail, log_p);
+}
+
+// Mode of the distribution, floor((n + 1) p).
+static unsigned binomMode(const unsigned n, const double p)
+{
+    return unsigned(fmin2(floor((n + 1.) * p), n));
+}
+
+// Smallest and largest k whose probability is at least DBL_MIN. The log pmf falls monotonically
+// away from the mode, so each edge is found by bisection.
+static void binomSupport(const unsigned n, const double p, unsigned* lo, unsigned* hi)
+{
+    const double q = 1. - p, floor_ = log(DBL_MIN);
+    const unsigned m = binomMode(n, p);
+
+    auto edge = [=](double inside, double outside)
+    {
+        if (binomLogPmf(outside, n, p, q) >= floor_)
+            return unsigned(outside);
+
+        while (fabs(outside - inside) > 1.)
+        {
+            double mid = floor((inside + outside) / 2.);
+
+            if (binomLogPmf(mid, n, p, q) >= floor_)
+                inside = mid;
+            else
+                outside = mid;
+        }
+
+        return unsigned(inside);
+    };
+
+    if (p == 0. || p == 1.)
+        *lo = *hi = m;
+    else
+    {
+        *lo = edge(m, 0.);
+        *hi = edge(m, n);
+    }
+}
+
+// Terms of binomPMF between fresh evaluations of the pmf, so rounding in the recurrence cannot build up.
+constexpr size_t BINOM_PMF_BLOCK = 512;
+
+// out[k] = P(X = k) for lo <= k <= hi, 0 <= p <= 1. The terms follow the ratio
+// f(k + 1) = f(k) (n - k) / (k + 1) p / (1 - p) from a saddle point value at the start of each block of
+// BINOM_PMF_BLOCK terms. The ratios of a block are independent divisions, which vectorize, and the
+// blocks are spread over the thread pool.
+static void binomPmfRange(const unsigned n, const double p, const unsigned lo, const unsigned hi, double* out)
+{
+    const double q = 1. - p, c = p / q;
+
+    parallelFor(size_t(hi - lo) + 1, [&](size_t begin, size_t end)
+    {
+        double r[BINOM_PMF_BLOCK];
+
+        for (size_t b = begin; b < end; b += BINOM_PMF_BLOCK)
+        {
+            size_t m = std::min(end - b, BINOM_PMF_BLOCK);
+            double k0 = double(lo) + double(b), f = binomPmf(k0, n, p, q);
+            double* o = out + lo + b;
+
+            for (size_t j = 0; j + 1 < m; j++)
+                r[j] = (n - k0 - double(j)) * c / (k0 + double(j) + 1.);
+
+            o[0] = f;
+            for (size_t j = 1; j < m; j++)
+                o[j] = (f *= r[j - 1]);
+        }
+    });
+}
+
+// Whole distribution, out[k] = P(X = k) for k = 0 ... n; out must hold n + 1 values. Probabilities
+// below DBL_MIN are set to 0, so only the O(sqrt(n)) terms around the mode are computed.
+void binomPMF(const unsigned n, const double p, std::span<double> out)
+{
+    assert(out.size() > n);
+
+    if (!(p >= 0. && p <= 1.))
+    {
+        std::fill(out.begin(), out.begin() + n + 1, NAN);
+        return;
+    }
+
+    unsigned lo, hi;
 
-    return std::exp(lgr);
+    binomSupport(n, p, &lo, &hi);
+    std::fill(out.begin(), out.begin() + lo, 0.);
+    std::fill(out.begin() + hi + 1, out.begin() + n + 1, 0.);
+    binomPmfRange(n, p, lo, hi, out.data());
 }
 
-// Binomial CDF.
-double pBinom(const unsigned k, const unsigned n, const double p)
+// Whole distribution function, out[k] = P(X <= k), or P(X > k) for the upper tail, k = 0 ... n.
+// Below the mode the lower tail is summed from the left, above it the upper tail from the right,
+// so each is the sum of the terms it consists of and both tails keep their relative precision.
+void binomCDF(const unsigned n, const double p, std::span<double> out, const bool lower_tail = true)
 {
-    double cdf = 0.;
-    double b = 0.;
+    assert(out.size() > n);
 
-    for (unsigned _k = 1; _k <= (unsigned)k; _k++)
+    if (!(p >= 0. && p <= 1.))
     {
-        double log_pmf_k = 0.;
+        std::fill(out.begin(), out.begin() + n + 1, NAN);
+        return;
+    }
+
+    unsigned lo, hi, m = binomMode(n, p);
+    double s = 0.;
 
-        b += +log(n - _k + 1.) - log(_k);
-        log_pmf_k = b + _k * log(p) + (n - _k) * log(1. - p);
-        cdf += exp(log_pmf_k);
+    binomSupport(n, p, &lo, &hi);
+    std::fill(out.begin(), out.begin() + lo, lower_tail ? 0. : 1.);
+    std::fill(out.begin() + hi + 1, out.begin() + n + 1, lower_tail ? 1. : 0.);
+    binomPmfRange(n, p, lo, hi, out.data());
+
+    for (unsigned k = lo; k < m; k++)
+    {
+        s += out[k];
+        out[k] = lower_tail ? s : 1. - s;
     }
 
-    return cdf;
+    s = 0.;
+    for (unsigned k = hi + 1; k-- > m; )
+    {
+        double f = out[k];
+        out[k] = lower_tail ? 1. - s : s;
+        s += f;
+    }
 }
 
+// Step y by incr until F(y - incr) < p <= F(y), z = F(y). Unit steps update F by the pmf recurrence
+// f(y + 1) = f(y) (n - y) / (y + 1) pr / (1 - pr) instead of evaluating pBinom again.
 static double doBinomSearch(double y, double* z, double p, double n, double pr, double incr)
 {
+    double q = 1. - pr, f;
+
+    if (incr == 1. && (f = binomPmf(y, n, pr, q)) > 0.)
+    {
+        if (*z >= p)
+        {
+            // Search to left, F(y - 1) = F(y) - f(y). The difference cancels as F falls into a deep
+            // lower tail, so F is evaluated afresh each time it drops by a factor 100.
+            for (double zref = *z;;)
+            {
+                double newz = *z - f;
+
+                if (y > 0 && newz < 0.01 * zref)
+                    zref = newz = pBinom((unsigned)(y - 1), (unsigned)n, pr);
+                if (y == 0 || newz < p)
+                    return y;
+                f *= y / (n - y + 1.) * q / pr;
+                y--;
+                *z = newz;
+            }
+        }
+        else
+        {
+            // Search to right.
+            for (;;)
+            {
+                if (y == n)
+                    return y;
+                f *= (n - y) / (y + 1.) * pr / q;
+                y++;
+                if ((*z += f) >= p)
+                    return y;
+            }
+        }
+    }
+
     if (*z >= p) 
     {
         // Search to left.
@@ -71,7 +261,7 @@ static double doBinomSearch(double y, double* z, double p, double n, double pr,
         {
             double newz;
 
-            if (y == 0 || (newz = pBinom((unsigned)(y - incr), (unsigned)n, pr)) < p)
+            if (y == 0 || (newz = (y < incr) ? 0. : pBinom((unsigned)(y - incr), (unsigned)n, pr)) < p)
                 return y;
             y = fmax2(0, y - incr);
             *z = newz;
@@ -89,70 +279,125 @@ static double doBinomSearch(double y, double* z, double p, double n, double pr,
     }
 }
 
-// The quantile function of the binomial distribution.
-double qBinom(double p, double n, double pr)
+// Cornish-Fisher start for the search.
+static double binomStart(const double p, const double n, const double pr)
 {
-    double q, mu, sigma, gamma, z, y;
+    double q = 1 - pr;
+    double mu = n * pr;
+    double sigma = sqrt(n * pr * q);
+    double gamma = (q - pr) / sigma;
+    double z = qNorm(p, 0., 1.);
+
+    return fmax2(0, fmin2(floor(mu + sigma * (z + gamma * (z * z - 1) / 6) + 0.5), n));
+}
+
+// Search from y, z = F(y): unit steps for small n, otherwise steps shrinking by 100 from n / 1000.
+static double binomSearch(double y, double* z, double p, double n, double pr)
+{
+    if (n < 1e5)
+        return doBinomSearch(y, z, p, n, pr, 1);
 
+    double incr = floor(n * 0.001), oldincr;
+
+    do 
+    {
+      oldincr = incr;
+      y = doBinomSearch(y, z, p, n, pr, incr);
+      incr = fmax2(1, floor(incr / 100));
+    } while (oldincr > 1 && incr > n * 1e-15);
+
+    return y;
+}
+
+// Arguments the search cannot take, with the quantile to return for them (NAN when invalid).
+static bool binomSpecial(const double p, const double n, const double pr, double* y)
+{
 #ifdef IEEE_754
     if (isnan(p) || isnan(n) || isnan(pr))
-        return p + n + pr;
+    {
+        *y = p + n + pr;
+        return true;
+    }
 #endif
 
-    if (!isfinite(n) || !isfinite(pr))
-        return NAN;
-
-    if (!isfinite(p))
-        return NAN;
+    *y = NAN;
+    if (!isfinite(n) || !isfinite(pr) || !isfinite(p))
+        return true;
 
     if (n != floor(n + 0.5))
-        return NAN;
+        return true;
 
     if (pr < 0 || pr > 1 || n < 0)
-        return NAN;
+        return true;
 
     if (p < 0 || p > 1)
-      return NAN;
-    if (p == 0)
-      return 0;
-    if (p == 1)
-      return n;
-  
-    if (pr == 0. || n == 0)
-        return 0.;
+      return true;
 
-    q = 1 - pr;
-    if (q == 0.)
-        return n;
+    if (p == 0 || p == 1)
+    {
+        *y = p * n;
+        return true;
+    }
 
-    mu = n * pr;
-    sigma = sqrt(n * pr * q);
-    gamma = (q - pr) / sigma;
+    if (pr == 0. || n == 0)
+    {
+        *y = 0.;
+        return true;
+    }
 
-    if (p + 1.01 * DBL_EPSILON >= 1.)
-        return n;
+    *y = n;
+    return (1 - pr == 0. || p + 1.01 * DBL_EPSILON >= 1.);
+}
 
-    z = qNorm(p, 0., 1.);
-    y = floor(mu + sigma * (z + gamma * (z * z - 1) / 6) + 0.5);
+// The quantile function of the binomial distribution.
+double qBinom(double p, double n, double pr)
+{
+    double y, z;
 
-    if (y > n) 
-        y = n;
+    if (binomSpecial(p, n, pr, &y))
+        return y;
 
+    y = binomStart(p, n, pr);
     z = pBinom((unsigned)y, (unsigned)n, pr);
 
     p *= 1 - 64 * DBL_EPSILON;
 
-    if (n < 1e5)
-        return doBinomSearch(y, &z, p, n, pr, 1);
+    return binomSearch(y, &z, p, n, pr);
+}
 
-    double incr = floor(n * 0.001), oldincr;
+// Quantiles of a vector of probabilities in one sweep. They are answered in increasing order of p,
+// each search continuing from the previous quantile with the incremental CDF; a start more than 64
+// above it begins a fresh search.
+std::vector<double> qBinom(const std::vector<double>& p, const double n, const double pr)
+{
+    std::vector<double> y(p.size());
+    std::vector<size_t> order;
 
-    do 
+    for (size_t i = 0; i < p.size(); i++)
+        if (!binomSpecial(p[i], n, pr, &y[i]))
+            order.push_back(i);
+
+    std::sort(order.begin(), order.end(), [&p](const size_t a, const size_t b) { return p[a] < p[b]; });
+
+    double yc = -1., zc = 0.;
+    for (size_t i : order)
     {
-      oldincr = incr;
-      y = doBinomSearch(y, &z, p, n, pr, incr);
-      incr = fmax2(1, floor(incr / 100));
-    } while (oldincr > 1 && incr > n * 1e-15);
+        double pi = p[i] * (1 - 64 * DBL_EPSILON);
+        double start = binomStart(p[i], n, pr);
+
+        if (yc == n)
+            ;
+        else if (yc < 0. || start - yc > 64.)
+        {
+            yc = start;
+            zc = pBinom((unsigned)yc, (unsigned)n, pr);
+            yc = binomSearch(yc, &zc, pi, n, pr);
+        }
+        else
+            yc = doBinomSearch(yc, &zc, pi, n, pr, 1);
+
+        y[i] = yc;
+    }
 
     return y;
 }
@@ -198,7 +198,7 @@ double dchisq(double x, double df) { return dgamma(x, df / 2., 2.); }
 // The distribution function of the chi - squared distribution.
 double pchisq(double x, double df) { return pgamma(x, df / 2., 2., true); }
 
-// The quantile function of the chi-squared distribution.
-double qchisq(double p, double df) { return qgamma(p, 0.5 * df, 2.0, true); }
+// The quantile function of the chi-squared distribution, solved to full precision in a constant expression.
+constexpr double qchisq(double p, double df) { return std::is_constant_evaluated() ? cxQChisq(p, df) : qgamma(p, 0.5 * df, 2.0, true); }
 
 #endif
@@ -8,13 +8,27 @@
 #include <limits>
 #include <algorithm>
 #include <numeric>
+#include <vector>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <cstdint>
+#include <functional>
 #include <cassert>
+#include <bit>
+#include <atomic>
+#include <mutex>
+#include "simd.h"
+#include "parallel.h"
+#include "critical.h"
 
 #define IEEE_754 1
 
-extern double pNorm(const double, const double, const double);
+constexpr double pNorm(const double, const double, const double);
+extern double pNorm(const double, const double, const double, const bool, const bool);
 extern double dNorm(const double x, const double, const double);
-extern double qNorm(const double, const double, const double);
+constexpr double qNorm(const double, const double, const double);
+extern double pt(double, unsigned int);
 
 //#define ML_POSINF  std::numeric_limits<double>::infinity()
 #define ML_POSINF  DBL_MAX
@@ -49,8 +63,8 @@ double meanMoE2(const unsigned n1, const unsigned n2, const double sigma1, const
 double proportionN(const double MoE, const double z, const double phat) { return (phat * (1. - phat) * pow((z / MoE), 2.)); }
 double meanN(const double MoE, const double z, const double sigma) { return pow((z*sigma)/MoE, 2); }
 // Confidence intervals z-scores.
-constexpr double Z95CI = 1.95996; // -1.95996 (right tail). Z95CI = qNorm(.95 + (1 - .95)/ 2);
-constexpr double Z90CI = 1.64485; // -1.64485 (right tail).
+constexpr double Z95CI = zCritical(0.025); // 1.95996 (right tail), qNorm(.95 + (1 - .95) / 2)
+constexpr double Z90CI = zCritical(0.05);  // 1.64485 (right tail)
 
 // Hypothesis testing z and t, 1-sample.
 double proportionHypothesisZ(const unsigned n, const double phat, const double p0) { return ((phat - p0) / sqrt((p0 * (1. - p0)) / n)); }
@@ -75,23 +89,161 @@ double chisq(const double O, const double E) { return pow(O - E, 2.) / E; }
 template<typename T>
 T findChiSquare(const std::vector<T>& O, std::vector<T>& E)
 {
-    std::vector<T> csq;
+    auto chunk = [&](size_t begin, size_t end)
+    {
+        double csq = 0.;
+        for (size_t i = begin; i < end; i++)
+            csq += chisq(O[i], E[i]);
+        return csq;
+    };
 
-    for (unsigned i = 0; i < O.size(); i++)
-        csq.push_back(chisq(O[i], E[i]));
-    
-    return std::accumulate(csq.begin(), csq.end(), 0.);
+    return T(parallelReduce<double>(O.size(), chunk, std::plus<double>()));
 }
 
 
+// Non-owning, read-only view over elements spaced a fixed number of bytes apart, e.g. one
+// member of an array of structs or one column of a row-major table, without copying it out.
+template<typename T>
+class StridedView
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_cv_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+        iterator(const char* p, size_t stride) : p(p), stride(stride) { }
+
+        reference operator*() const { return *reinterpret_cast<const T*>(p); }
+        pointer operator->() const { return reinterpret_cast<const T*>(p); }
+        iterator& operator++() { p += stride; return *this; }
+        iterator operator++(int) { iterator it = *this; p += stride; return it; }
+        bool operator==(const iterator& other) const { return p == other.p; }
+        bool operator!=(const iterator& other) const { return p != other.p; }
+
+    private:
+        const char* p = nullptr;
+        size_t stride = 0;
+    };
+
+    StridedView() = default;
+    StridedView(const T* first, const size_t n, const size_t strideBytes = sizeof(T)) : first(reinterpret_cast<const char*>(first)), n(n), stride(strideBytes) { }
+
+    iterator begin() const { return iterator(first, stride); }
+    iterator end() const { return iterator(first + n * stride, stride); }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+
+private:
+    const char* first = nullptr;
+    size_t n = 0;
+    size_t stride = sizeof(T);
+};
+
+// Element type of an iterator or range, without cv-qualifiers.
+template<typename It>
+using IterValue = std::remove_cv_t<typename std::iterator_traits<It>::value_type>;
+template<typename R>
+using RangeValue = std::remove_cv_t<std::ranges::range_value_t<R>>;
+
+// Online (streaming) mean and variance accumulator.
+//   Values are added with the Welford update; partial accumulators gathered over separate 
+//   slices (threads, shards, processes) combine exactly with merge() (Chan et al.), so 
+//   mean/variance/standardDeviation never require a second pass or the data in memory.
+class RunningStats
+{
+public:
+    RunningStats() = default;
+    // State of n values with the given mean and sum of squared deviations m2.
+    RunningStats(const size_t n, const double mean, const double m2) : n(n), mu(mean), m2(m2) { }
+
+    void push(const double x)
+    {
+        n++;
+        double delta = x - mu;
+        mu += delta / n;
+        m2 += delta * (x - mu);
+    }
+
+    template<typename It>
+    void push(It first, It last)
+    {
+        for (; first != last; ++first)
+            push(double(*first));
+    }
+
+    // Combine the state of another accumulator into this one.
+    void merge(const RunningStats& other)
+    {
+        if (other.n == 0)
+            return;
+
+        if (n == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        double na = double(n), nb = double(other.n), nab = na + nb;
+        double delta = other.mu - mu;
+
+        mu += delta * nb / nab;
+        m2 += other.m2 + delta * delta * na * nb / nab;
+        n += other.n;
+    }
+
+    size_t count() const { return n; }
+    double mean() const { return mu; }
+    // Sample variance (n - 1), matching variance().
+    double variance() const { return (n > 1) ? m2 / (n - 1) : 0.; }
+    double standardDeviation() const { return sqrt(variance()); }
+
+private:
+    size_t n = 0;
+    double mu = 0.;
+    double m2 = 0.;
+};
+
 // Average for the data set.
+template<typename It>
+IterValue<It> mean(It first, It last)
+{
+    if constexpr (std::contiguous_iterator<It> && std::is_same_v<IterValue<It>, double>)
+    {
+        size_t n = size_t(last - first);
+        const double* x = std::to_address(first);
+        auto chunk = [x](size_t begin, size_t end) { return simdSum(x + begin, end - begin); };
+
+        return (n == 0) ? 0. : parallelReduce<double>(n, chunk, std::plus<double>()) / n;
+    }
+
+    double sum = 0.;
+    size_t n = 0;
+
+    for (; first != last; ++first, ++n)
+        sum += *first;
+
+    if (n == 0)
+        return { };
+
+    return IterValue<It>(sum / n);
+}
+
 template<typename T>
 T mean(const std::vector<T>& v)
 {
-    if (v.empty())
-        return { };
+    return mean(v.begin(), v.end());
+}
 
-    return std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+template<std::ranges::forward_range R>
+RangeValue<R> mean(const R& r)
+{
+    return mean(std::ranges::begin(r), std::ranges::end(r));
 }
 
 //  Middle value of the data set.
@@ -104,130 +256,655 @@ T median(std::vector<T> v)
     size_t n = v.size() / 2;
     nth_element(v.begin(), v.begin() + n, v.end());
 
+    // Even count, average the two middle values (lower one is the largest of the left partition).
+    if (v.size() % 2 == 0)
+        return (*std::max_element(v.begin(), v.begin() + n) + v[n]) / 2;
+
     return v[n];
 }
 
-// Number that occurs the most in data set.
+// Selection reorders, so this is the only place a scratch copy of the data is made.
+template<typename It>
+IterValue<It> median(It first, It last)
+{
+    return median(std::vector<IterValue<It>>(first, last));
+}
+
+template<std::ranges::forward_range R>
+RangeValue<R> median(const R& r)
+{
+    return median(std::ranges::begin(r), std::ranges::end(r));
+}
+
+// Value/count table built with open addressing (linear probing, power-of-two capacity).
+//   Tables gathered over separate slices of the data combine with merge().
 template<typename T>
-T mode(std::vector<T> v)
+class FrequencyTable
 {
-    if (v.empty())
-        return { };
+public:
+    FrequencyTable() : keys(16), counts(16, 0) { }
+
+    void add(const T& x, const size_t count = 1)
+    {
+        if (count == 0)
+            return;
+
+        if (2 * (distinct + 1) > keys.size())
+            rehash(2 * keys.size());
+
+        size_t i = find(x);
+        if (counts[i] == 0)
+        {
+            keys[i] = x;
+            distinct++;
+        }
+        counts[i] += count;
+        n += count;
+    }
 
-    std::sort(v.begin(), v.end());
+    template<typename It>
+    void add(It first, It last)
+    {
+        for (; first != last; ++first)
+            add(*first);
+    }
 
-    // Finding max frequency.
-    unsigned max_count = 1, count = 1;
-    T r = *v.begin();
+    void merge(const FrequencyTable& other)
+    {
+        for (size_t i = 0; i < other.keys.size(); i++)
+            if (other.counts[i] != 0)
+                add(other.keys[i], other.counts[i]);
+    }
 
-    for (auto it = v.begin(); it != v.end(); ++it)
+    size_t count(const T& x) const
     {
-        if (it != v.begin() && *it == *(it - 1))
-            count++;
-        else
+        return counts[find(x)];
+    }
+
+    // Number of distinct values and total number of observations.
+    size_t size() const { return distinct; }
+    size_t total() const { return n; }
+    bool empty() const { return n == 0; }
+
+    // Most frequent value, the smallest one on ties.
+    T mode() const
+    {
+        T r{ };
+        size_t max_count = 0;
+
+        for (size_t i = 0; i < keys.size(); i++)
         {
-            if (count > max_count)
+            if (counts[i] > max_count || (counts[i] == max_count && counts[i] != 0 && keys[i] < r))
             {
-                max_count = count;
-                r = *(it - 1);
+                max_count = counts[i];
+                r = keys[i];
             }
-            count = 1;
         }
+
+        return r;
     }
 
-    // When the last element is most frequent.
-    if (count > max_count)
+    // The k most frequent values with their counts, most frequent first (ties by value).
+    std::vector<std::pair<T, size_t>> top(size_t k) const
     {
-        max_count = count;
-        r = v[v.size() - 1];
+        std::vector<std::pair<T, size_t>> t = entries();
+        auto more = [](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) { return a.second > b.second || (a.second == b.second && a.first < b.first); };
+
+        k = std::min(k, t.size());
+        std::partial_sort(t.begin(), t.begin() + k, t.end(), more);
+        t.resize(k);
+
+        return t;
     }
 
-    // index = max_count;
-    return r;
+    // Every distinct value with its count, ordered by value.
+    std::vector<std::pair<T, size_t>> table() const
+    {
+        std::vector<std::pair<T, size_t>> t = entries();
+
+        std::sort(t.begin(), t.end(), [](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) { return a.first < b.first; });
+
+        return t;
+    }
+
+    // Observed counts of the given categories, in order (e.g. for findChiSquare).
+    std::vector<double> observed(const std::vector<T>& categories) const
+    {
+        std::vector<double> o(categories.size());
+
+        for (size_t i = 0; i < categories.size(); i++)
+            o[i] = double(count(categories[i]));
+
+        return o;
+    }
+
+private:
+    std::vector<T> keys;
+    std::vector<size_t> counts; // 0 marks an empty slot
+    size_t distinct = 0;
+    size_t n = 0;
+
+    static uint64_t mix(uint64_t h)
+    {
+        // splitmix64 finalizer, std::hash of integers is commonly the identity.
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    size_t find(const T& x) const
+    {
+        size_t mask = keys.size() - 1;
+        size_t i = size_t(mix(uint64_t(std::hash<T>()(x)))) & mask;
+
+        while (counts[i] != 0 && !(keys[i] == x))
+            i = (i + 1) & mask;
+
+        return i;
+    }
+
+    void rehash(const size_t capacity)
+    {
+        std::vector<T> k(capacity);
+        std::vector<size_t> c(capacity, 0);
+
+        keys.swap(k);
+        counts.swap(c);
+        for (size_t i = 0; i < k.size(); i++)
+        {
+            if (c[i] != 0)
+            {
+                size_t j = find(k[i]);
+                keys[j] = k[i];
+                counts[j] = c[i];
+            }
+        }
+    }
+
+    std::vector<std::pair<T, size_t>> entries() const
+    {
+        std::vector<std::pair<T, size_t>> t;
+
+        t.reserve(distinct);
+        for (size_t i = 0; i < keys.size(); i++)
+            if (counts[i] != 0)
+                t.emplace_back(keys[i], counts[i]);
+
+        return t;
+    }
+};
+
+// Integer data spanning at most this many values (and no more than the count) is tallied in a dense array.
+constexpr size_t FREQUENCY_DENSE_MAX = 1u << 20;
+// Inputs longer than this are tallied per thread and the tables merged.
+constexpr size_t FREQUENCY_PARALLEL_MIN = 1u << 18;
+
+template<typename It>
+FrequencyTable<IterValue<It>> frequenciesSerial(It first, It last)
+{
+    using T = IterValue<It>;
+    FrequencyTable<T> f;
+
+    if (first == last)
+        return f;
+
+    if constexpr (std::is_integral_v<T>)
+    {
+        // Counting path for small-range integers: one pass for the range, one to tally.
+        T lo = *first, hi = *first;
+        size_t n = 0;
+
+        for (It it = first; it != last; ++it, ++n)
+        {
+            lo = std::min(lo, *it);
+            hi = std::max(hi, *it);
+        }
+
+        uint64_t range = uint64_t(hi) - uint64_t(lo);
+        if (range < FREQUENCY_DENSE_MAX && range < n)
+        {
+            std::vector<size_t> c(size_t(range) + 1, 0);
+
+            for (; first != last; ++first)
+                c[size_t(uint64_t(*first) - uint64_t(lo))]++;
+
+            for (size_t i = 0; i < c.size(); i++)
+                f.add(T(uint64_t(lo) + i), c[i]);
+
+            return f;
+        }
+    }
+
+    f.add(first, last);
+
+    return f;
+}
+
+// Frequency table of the data set.
+template<typename It>
+FrequencyTable<IterValue<It>> frequencies(It first, It last)
+{
+    if constexpr (std::random_access_iterator<It>)
+    {
+        size_t n = size_t(last - first);
+        unsigned threads = threadPool().size();
+
+        // One table per thread, merged in order.
+        if (threads > 1 && n > FREQUENCY_PARALLEL_MIN)
+        {
+            std::vector<FrequencyTable<IterValue<It>>> parts(threads);
+            size_t chunk = (n + threads - 1) / threads;
+
+            threadPool().run(threads, [&](size_t t)
+            {
+                size_t begin = std::min(n, t * chunk);
+                parts[t] = frequenciesSerial(first + begin, first + std::min(n, begin + chunk));
+            });
+
+            for (unsigned t = 1; t < threads; t++)
+                parts[0].merge(parts[t]);
+
+            return parts[0];
+        }
+    }
+
+    return frequenciesSerial(first, last);
+}
+
+template<std::ranges::forward_range R>
+FrequencyTable<RangeValue<R>> frequencies(const R& r)
+{
+    return frequencies(std::ranges::begin(r), std::ranges::end(r));
+}
+
+// Chi-square of a frequency table's counts against the expected counts of the listed categories.
+template<typename K, typename T>
+T findChiSquare(const FrequencyTable<K>& O, const std::vector<K>& categories, std::vector<T>& E)
+{
+    std::vector<double> o = O.observed(categories);
+    std::vector<T> csq;
+
+    for (unsigned i = 0; i < o.size(); i++)
+        csq.push_back(chisq(o[i], E[i]));
+
+    return std::accumulate(csq.begin(), csq.end(), 0.);
+}
+
+// Number that occurs the most in data set (smallest value on ties).
+template<typename It>
+IterValue<It> mode(It first, It last)
+{
+    if (first == last)
+        return { };
+
+    return frequencies(first, last).mode();
+}
+
+template<typename T>
+T mode(const std::vector<T>& v)
+{
+    return mode(v.begin(), v.end());
+}
+
+template<std::ranges::forward_range R>
+RangeValue<R> mode(const R& r)
+{
+    return mode(std::ranges::begin(r), std::ranges::end(r));
 }
 
 // Measure of how far a set of data are dispersed from their mean.
+template<typename It>
+IterValue<It> variance(It first, It last)
+{
+    if constexpr (std::contiguous_iterator<It> && std::is_same_v<IterValue<It>, double>)
+    {
+        size_t n = size_t(last - first);
+        if (n == 0)
+            return 0.;
+
+        // Per chunk two passes, the mean then squares centered on it (s1 corrects its rounding),
+        // while the chunk is still in cache. Chunks are combined with RunningStats::merge.
+        const double* x = std::to_address(first);
+        auto chunk = [x](size_t begin, size_t end)
+        {
+            size_t m = end - begin;
+            double mu = simdSum(x + begin, m) / m, s1, s2;
+            simdSumSquares(x + begin, m, mu, s1, s2);
+            return RunningStats(m, mu + s1 / m, s2 - s1 * s1 / m);
+        };
+        auto combine = [](RunningStats a, const RunningStats& b) { a.merge(b); return a; };
+
+        return parallelReduce<RunningStats>(n, chunk, combine).variance();
+    }
+
+    double sum = 0.;
+    size_t n = 0;
+
+    for (It it = first; it != last; ++it, ++n)
+        sum += *it;
+
+    if (n == 0)
+        return { };
+
+    const double mean = sum / n;
+    double ss = 0.;
+
+    for (; first != last; ++first)
+        ss += (*first - mean) * (*first - mean);
+
+    return IterValue<It>(ss / (n - 1));
+}
+
 template<typename T>
 T variance(const std::vector<T>& v)
 {
-    if (v.empty())
+    return variance(v.begin(), v.end());
+}
+
+template<std::ranges::forward_range R>
+RangeValue<R> variance(const R& r)
+{
+    return variance(std::ranges::begin(r), std::ranges::end(r));
+}
+
+// Measure of dispersement (tells how much data is spread out).
+template<typename It>
+IterValue<It> standardDeviation(It first, It last)
+{
+    if (first == last)
         return { };
 
-    unsigned sz = v.size();
-    const T mean = std::accumulate(v.begin(), v.end(), 0.0) / sz;
-    auto variance_func = [&mean, &sz](T accumulator, const T& val) { return accumulator + ((val - mean) * (val - mean) / (sz - 1)); };
+    return sqrt(variance(first, last));
+}
+
+template<typename T>
+T standardDeviation(const std::vector<T>& v)
+{
+    return standardDeviation(v.begin(), v.end());
+}
 
-    return std::accumulate(v.begin(), v.end(), 0.0, variance_func);
+template<std::ranges::forward_range R>
+RangeValue<R> standardDeviation(const R& r)
+{
+    return standardDeviation(std::ranges::begin(r), std::ranges::end(r));
 }
 
-// Measure of dispersement (tells how much data is spread out).
+// Descriptive summary of a data set.
+//   Skewness and kurtosis are the moment estimators g1 and g2 (kurtosis is excess, normal = 0).
 template<typename T>
-T standardDeviation(std::vector<T> v)
+struct Summary
 {
-    if (v.empty())
-        return { };
+    size_t count = 0;
+    double mean = 0.;
+    double variance = 0.;
+    double standardDeviation = 0.;
+    T min{ };
+    T max{ };
+    double skewness = 0.;
+    double kurtosis = 0.;
+};
+
+// Gather the descriptive summary in a single pass over the data.
+//   Central moments are updated incrementally (Welford/Terriberry), so no second pass 
+//   over the data for the mean is required and no cancellation occurs for large offsets.
+template<typename It>
+Summary<IterValue<It>> summarize(It first, It last)
+{
+    using T = IterValue<It>;
+    Summary<T> s;
+
+    if (first == last)
+        return s;
+
+    double n = 0., mu = 0., m2 = 0., m3 = 0., m4 = 0.;
+    T lo = *first, hi = *first;
+
+    for (; first != last; ++first)
+    {
+        const T x = *first;
+        double n1 = n;
+        n += 1.;
+
+        double delta = double(x) - mu;
+        double delta_n = delta / n;
+        double delta_n2 = delta_n * delta_n;
+        double term1 = delta * delta_n * n1;
+
+        mu += delta_n;
+        m4 += term1 * delta_n2 * (n * n - 3. * n + 3.) + 6. * delta_n2 * m2 - 4. * delta_n * m3;
+        m3 += term1 * delta_n * (n - 2.) - 3. * delta_n * m2;
+        m2 += term1;
+
+        if (x < lo)
+            lo = x;
+        if (hi < x)
+            hi = x;
+    }
 
-    return sqrt(variance(v));
+    s.count = size_t(n);
+    s.mean = mu;
+    s.variance = (s.count > 1) ? m2 / (n - 1.) : 0.;
+    s.standardDeviation = sqrt(s.variance);
+    s.min = lo;
+    s.max = hi;
+    s.skewness = (m2 > 0.) ? sqrt(n) * m3 / pow(m2, 1.5) : NAN;
+    s.kurtosis = (m2 > 0.) ? n * m4 / (m2 * m2) - 3. : NAN;
+
+    return s;
 }
 
-// Measure of how many standard deviations above/below the population mean.
 template<typename T>
-T zScore(const T x, const std::vector<T> v)
+Summary<T> summarize(const std::vector<T>& v)
 {
-    if (v.empty())
+    return summarize(v.begin(), v.end());
+}
+
+template<std::ranges::forward_range R>
+Summary<RangeValue<R>> summarize(const R& r)
+{
+    return summarize(std::ranges::begin(r), std::ranges::end(r));
+}
+
+// Measure of how many standard deviations above/below the population mean.
+template<typename It>
+IterValue<It> zScore(const IterValue<It> x, It first, It last)
+{
+    if (first == last)
         return { };
 
-    return ((x - mean(v)) / standardDeviation(v));
+    Summary<IterValue<It>> s = summarize(first, last);
+
+    return IterValue<It>((x - s.mean) / s.standardDeviation);
 }
 
-// lsq data fit. Returns std::pair(m, b)
-std::pair<double, double> lsq(const std::vector<double>& x, const std::vector<double>& y)
+template<typename T>
+T zScore(const T x, const std::vector<T>& v)
 {
-    assert(x.size() == y.size());
+    return zScore(x, v.begin(), v.end());
+}
+
+template<std::ranges::forward_range R>
+RangeValue<R> zScore(const RangeValue<R> x, const R& r)
+{
+    return zScore(x, std::ranges::begin(r), std::ranges::end(r));
+}
+
+// z-scores for every element of the data set, using a previously gathered summary.
+template<std::ranges::forward_range R>
+std::vector<double> zScores(const R& r, const Summary<RangeValue<R>>& s)
+{
+    std::vector<double> z;
+    const double mu = s.mean, inv_sd = 1. / s.standardDeviation;
+
+    z.reserve(s.count);
+    for (const auto& x : r)
+        z.push_back((double(x) - mu) * inv_sd);
+
+    return z;
+}
+
+// z-scores for every element of the data set (one summary pass plus one scoring pass).
+template<std::ranges::forward_range R>
+std::vector<double> zScores(const R& r)
+{
+    return zScores(r, summarize(r));
+}
 
-    double f = 0., g = 0., h = 0., j = 0.;
-    size_t pts = x.size();
+// Single-pass simple linear regression and correlation of paired data.
+//   Keeps the count, means and centered sums of squares and cross products, updated per pair
+//   (Welford) or combined with merge() (Chan et al.), so a fit over slices gathered on separate
+//   threads or shards needs neither a second pass nor the data in memory.
+//   Every statistic of y = mx + b and Pearson's r follows from the six moments.
+//   As an online (recursive least squares) fit each update is O(1): remove() takes a pair back
+//   out for sliding windows and decay(f) down-weights the history for exponential forgetting.
+class Bivariate
+{
+public:
+    Bivariate() = default;
+    // State of n pairs (total weight for weighted data) with the given means and centered sums.
+    Bivariate(const double n, const double mx, const double my, const double sxx, const double sxy, const double syy)
+        : n(n), mx(mx), my(my), sxx(sxx), sxy(sxy), syy(syy) { }
 
-    for (size_t i = 0; i < pts; i++)
+    void push(const double x, const double y)
     {
-        f = f + x[i] * x[i];
-        g = g + x[i];
-        h = h + x[i] * y[i];
-        j = j + y[i];
+        n++;
+        double dx = x - mx, dy = y - my;
+        mx += dx / n;
+        my += dy / n;
+        sxx += dx * (x - mx);
+        sxy += dx * (y - my);
+        syy += dy * (y - my);
     }
 
-    double m = (g * j - h * pts) / (g * g - f * pts);
-    double b = (g * h - f * j) / (g * g - f * pts);
+    // Take back a pair previously pushed (exact reverse of push).
+    void remove(const double x, const double y)
+    {
+        if (n <= 1.)
+        {
+            *this = Bivariate();
+            return;
+        }
+
+        double m = n - 1.;
+        double mx0 = mx - (x - mx) / m, my0 = my - (y - my) / m;
 
-    return std::make_pair(m, b);
-}
+        sxx -= (x - mx0) * (x - mx);
+        sxy -= (x - mx0) * (y - my);
+        syy -= (y - my0) * (y - my);
+        mx = mx0;
+        my = my0;
+        n = m;
+    }
 
-// Linear correlation coefficeint.
-double R(const std::vector<double>& x, const std::vector<double>& y)
+    // Multiply the weight of every pair so far by f (0 < f <= 1), e.g. decay(EWDecay(h).perSample)
+    // before each push. The means are unchanged; count() becomes the effective number of pairs.
+    void decay(const double f)
+    {
+        n *= f;
+        sxx *= f;
+        sxy *= f;
+        syy *= f;
+    }
+
+    // Combine the state of another accumulator into this one.
+    void merge(const Bivariate& other)
+    {
+        if (other.n == 0.)
+            return;
+
+        if (n == 0.)
+        {
+            *this = other;
+            return;
+        }
+
+        double nab = n + other.n, w = n * other.n / nab;
+        double dx = other.mx - mx, dy = other.my - my;
+
+        mx += dx * other.n / nab;
+        my += dy * other.n / nab;
+        sxx += other.sxx + dx * dx * w;
+        sxy += other.sxy + dx * dy * w;
+        syy += other.syy + dy * dy * w;
+        n = nab;
+    }
+
+    double count() const { return n; }
+    double meanX() const { return mx; }
+    double meanY() const { return my; }
+
+    // Least squares line y = slope * x + intercept.
+    double slope() const { return sxy / sxx; }
+    double intercept() const { return my - slope() * mx; }
+
+    // Pearson correlation coefficient (signed) and coefficient of determination.
+    double r() const { return sxy / sqrt(sxx * syy); }
+    double rSquared() const { return (sxy / sxx) * (sxy / syy); }
+
+    // Residual standard error, sqrt(SSE / (n - 2)).
+    double residualStandardError() const
+    {
+        return sqrt(fmax(syy - sxy * sxy / sxx, 0.) / (n - 2.));
+    }
+
+    // Standard errors of the slope and intercept.
+    double slopeStandardError() const { return residualStandardError() / sqrt(sxx); }
+    double interceptStandardError() const { return residualStandardError() * sqrt(1. / n + mx * mx / sxx); }
+
+    // t statistic and 2-tailed p-value for H0: slope = 0 (same test as H0: rho = 0), n - 2 degrees of freedom.
+    double slopeT() const { return slope() / slopeStandardError(); }
+    double slopePValue() const
+    {
+        assert(n > 2.);
+        return 2. * pt(-fabs(slopeT()), unsigned(n - 2.));
+    }
+
+private:
+    double n = 0.;
+    double mx = 0., my = 0.;
+    double sxx = 0., sxy = 0., syy = 0.;
+};
+
+// Fit of paired data in one pass over both vectors.
+static Bivariate bivariate(const std::vector<double>& x, const std::vector<double>& y)
 {
-    double	ymu = 0., dividend = 0., divisor = 0.;
-    size_t n = x.size();
+    assert(x.size() == y.size());
 
-    // y mean.
-    for (size_t i = 0; i < n; i++)
-        ymu += y[i];
-    ymu /= n;
+    auto chunk = [&x, &y](size_t begin, size_t end)
+    {
+        size_t m = end - begin;
+        double s[5];
+
+        if (m == 0)
+            return Bivariate();
+
+        // Center on the chunk means so the sums of squares do not cancel, s[0] and s[1] correct their rounding.
+        double mx = simdSum(x.data() + begin, m) / m;
+        double my = simdSum(y.data() + begin, m) / m;
+        simdCrossSums(x.data() + begin, y.data() + begin, m, mx, my, s);
+
+        return Bivariate(double(m), mx + s[0] / m, my + s[1] / m, s[2] - s[0] * s[0] / m, s[3] - s[0] * s[1] / m, s[4] - s[1] * s[1] / m);
+    };
+    auto combine = [](Bivariate a, const Bivariate& b) { a.merge(b); return a; };
 
-    // slope & y-int.
-    std::pair<double, double> mb = lsq(x, y);
+    return parallelReduce<Bivariate>(x.size(), chunk, combine);
+}
 
-    // variance y prime.
-    for (size_t i = 0; i < n; i++)
-        dividend = dividend + pow(((mb.first * x[i] + mb.second) - ymu), 2.);
-    dividend /= n;
+// lsq data fit. Returns std::pair(m, b)
+std::pair<double, double> lsq(const std::vector<double>& x, const std::vector<double>& y)
+{
+    Bivariate fit = bivariate(x, y);
 
-    // variance y.
-    for (size_t i = 0; i < n; i++)
-        divisor = divisor + pow((y[i] - ymu), 2.);
-    divisor /= n;
+    return std::make_pair(fit.slope(), fit.intercept());
+}
 
-    // correlation coefficient.
-    return sqrt(dividend / divisor);
+// Linear correlation coefficeint (signed, negative when y falls as x rises).
+double R(const std::vector<double>& x, const std::vector<double>& y)
+{
+    return bivariate(x, y).r();
 }
 
 double fmax2(double x, double y)
@@ -316,6 +993,82 @@ double stirlerr(double n)
     return((S0 - (S1 - (S2 - (S3 - S4 / nn) / nn) / nn) / nn) / n);
 }
 
+// log(n!) for integer n, shared by logChoose, dBinom and dPois so repeated evaluations are a lookup.
+// Values up to 170! come from the exact factorials, larger ones from Stirling's series with stirlerr.
+// n below LOG_FACTORIAL_MAX are kept in a table filled on first use, in segments of doubling size
+// and only as far as the largest n asked for. A filled segment never moves or changes, so a lookup
+// on any thread needs only an acquire load; filling is serialized by a mutex.
+class LogFactorialTable
+{
+public:
+    static constexpr unsigned FIRST = 256, SEGMENTS = 8;
+    static constexpr unsigned LOG_FACTORIAL_MAX = FIRST * ((1u << SEGMENTS) - 1);
+
+    double operator()(const unsigned n)
+    {
+        if (n >= LOG_FACTORIAL_MAX)
+            return stirling(n);
+
+        // Segment j holds n in [FIRST (2^j - 1), FIRST (2^(j+1) - 1)).
+        unsigned j = unsigned(std::bit_width(n / FIRST + 1)) - 1;
+        const double* s = segments[j].load(std::memory_order_acquire);
+
+        if (s == nullptr)
+            s = fill(j);
+
+        return s[n - FIRST * ((1u << j) - 1)];
+    }
+
+    static double stirling(const double n)
+    {
+        return stirlerr(n) + (n + 0.5) * log(n) - n + M_LN_SQRT_2PI;
+    }
+
+private:
+    std::atomic<const double*> segments[SEGMENTS] = { };
+    std::vector<double> storage[SEGMENTS];
+    std::mutex lock;
+
+    const double* fill(const unsigned j)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (storage[j].empty())
+        {
+            unsigned first = FIRST * ((1u << j) - 1);
+            double f = 1.;
+
+            storage[j].resize(size_t(FIRST) << j);
+            for (unsigned i = 2; i <= std::min(first, 170u); i++)
+                f *= i;
+            for (unsigned i = 0; i < storage[j].size(); i++)
+            {
+                unsigned n = first + i;
+
+                if (n > 1 && n <= 170)
+                    f *= n;
+                storage[j][i] = (n <= 170) ? log(f) : stirling(n);
+            }
+            segments[j].store(storage[j].data(), std::memory_order_release);
+        }
+
+        return storage[j].data();
+    }
+};
+
+double logFactorial(const unsigned n)
+{
+    static LogFactorialTable table;
+    return table(n);
+}
+
+// dBinom and dPois add log factorials directly while the magnitudes of the terms sum to at most
+// this, keeping the relative error near 1e-13; beyond it they cancel and the saddle point form is used.
+constexpr double LOG_FACTORIAL_DIRECT = 1024.;
+// Largest n with log(n!) <= LOG_FACTORIAL_DIRECT, so larger n go to the saddle point form without
+// touching the table.
+constexpr unsigned LOG_FACTORIAL_DIRECT_N = 229;
+
 #define M_SQRT_2PI  2.50662827463100050241576528481104525301  // sqrt(2*pi) 
 // sqrt(2 * Rmpfr::Const("pi", 128))
 #define x_LRG  2.86111748575702815380240589208115399625e+307  // = 2^1023 / pi
@@ -528,6 +1281,44 @@ static const float bd0_scale[128 + 1][4] = {
   { 0, 0, 0, 0 }
 };
 
+// Compute x * log (x / np) + (np - x), by its Taylor series when x is near np (Loader's bd0). Unlike
+// ebd0 it does not cancel M against M * fg there.
+double bd0(double x, double np)
+{
+    if (!isfinite(x) || !isfinite(np) || np == 0.)
+        return NAN;
+
+    if (fabs(x - np) < 0.1 * (x + np))
+    {
+        double v = (x - np) / (x + np);
+        double s = (x - np) * v;
+
+        if (fabs(s) < DBL_MIN)
+            return s;
+
+        double ej = 2 * x * v;
+        v *= v;
+        for (int j = 1; j < 1000; j++)
+        {
+            ej *= v;
+            double s_ = s;
+            s += ej / ((j << 1) + 1);
+            if (s == s_)
+                return s;
+        }
+    }
+
+    // np ((1 + t) log1p(t) - t), t = (x - np) / np, keeps x * log(x / np) from multiplying the
+    // rounding of x / np by x. x - np is exact within a factor 2 of np.
+    if (0.5 * np <= x && x <= 2. * np)
+    {
+        double t = (x - np) / np;
+        return np * (log1pmx(t) + t * log1p(t));
+    }
+
+    return x * log(x / np) + np - x;
+}
+
 #define ADD1(d_) do {              \
       double d = (d_);             \
       double d1 = floor (d + 0.5); \
@@ -901,10 +1692,7 @@ static double ppois_asymp(double x, double lambda, bool lower_tail)
         elfb = -elfb;
     f = res12 / elfb;
 
-    if (lower_tail)
-        np = 1. - pNorm(s2pt, 0.0, 1.0);
-    else
-        np = pNorm(s2pt, 0.0, 1.0);
+    np = pNorm(s2pt, 0.0, 1.0, !lower_tail, false);
 
     double nd = dNorm(s2pt, 0., 1.);
 
@@ -985,12 +1773,8 @@ double pgamma_raw(double x, double alph, int lower_tail)
         res = ppois_asymp(alph - 1, x, !lower_tail);
     }
 
-    if (res < DBL_MIN / DBL_EPSILON)
-    {
-        return exp(pgamma_raw(x, alph, lower_tail));
-    }
-    else
-        return res;
+    // R recomputes a result this small on the log scale; without log_p here, the direct value is kept.
+    return res;
 }
 
 double pgamma(double x, double alph, double scale, int lower_tail)
@@ -0,0 +1,430 @@
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include "common.h"
+#include "normal.h"
+#include "student.h"
+
+/*
+  Covariance and correlation matrices
+  All pairs of p columns (column-major data, one std::vector per column) in one blocked sweep
+  instead of p^2 / 2 calls to R(). Column means and variances take one pass; the cross products
+  are then computed a tile of 64 x 64 column pairs at a time: rows are taken in blocks of 256,
+  both column tiles of a block are centered into a cache-resident buffer and every pair is
+  reduced with the SIMD dot product kernel (GEMM style, each load of a column feeds four pairs).
+  Tiles run in parallel on the thread pool; each tile owns its part of the result, so results do
+  not depend on the thread count.
+  topCorrelations keeps only the k largest |r| of every tile and merges them, so the p x p
+  matrix is never stored.
+  Rank correlations, robust to outliers and heavy tails, are O(n log n):
+     Spearman rho is Pearson r of the ranks (ties get their average rank, sorted with parallelSort).
+     Kendall tau-b counts discordant pairs as the swaps of a merge sort (Knight, 1966).
+  Their p-values are 2-tailed and asymptotic, as cor.test(exact = FALSE): t with n - 2 degrees
+  of freedom for rho, normal with the tie-corrected variance of S for tau-b.
+  Usage:
+     covarianceMatrix(columns)          p x p, element (i, j) at [i * p + j], n - 1 divisor like cov()
+     correlationMatrix(columns)         p x p Pearson r, like cor()
+     topCorrelations(columns, k)        k pairs i < j with the largest |r|, strongest first
+     ranks(x)                           like rank(x)
+     spearman(x, y), kendall(x, y)      CorrelationTest { r, statistic, pValue }
+*/
+
+// Columns per tile and rows per block of the cross product sweep.
+constexpr size_t CORRELATION_TILE = 64;
+constexpr size_t CORRELATION_ROWS = 256;
+
+struct CorrelationPair
+{
+    size_t i, j;
+    double r;
+};
+
+// Means, centered sums of squares and the rounding left in the centered sums of every column.
+struct ColumnMoments
+{
+    size_t n = 0;
+    std::vector<double> mean, ss, s1;
+};
+
+static ColumnMoments columnMoments(const std::vector<std::vector<double>>& columns)
+{
+    ColumnMoments m;
+    size_t p = columns.size();
+
+    m.n = p ? columns[0].size() : 0;
+    m.mean.resize(p);
+    m.ss.resize(p);
+    m.s1.resize(p);
+
+    auto column = [&](size_t j)
+    {
+        const std::vector<double>& x = columns[j];
+
+        assert(x.size() == m.n);
+        m.mean[j] = (m.n == 0) ? 0. : simdSum(x.data(), m.n) / m.n;
+        simdSumSquares(x.data(), m.n, m.mean[j], m.s1[j], m.ss[j]);
+        m.ss[j] -= (m.n == 0) ? 0. : m.s1[j] * m.s1[j] / m.n;
+    };
+
+    if (m.n * p < parallelThreshold())
+        for (size_t j = 0; j < p; j++)
+            column(j);
+    else
+        threadPool().run(p, column);
+
+    return m;
+}
+
+// Centered cross products of every column pair of tile (a, b), a <= b, over all rows.
+// out[u * CORRELATION_TILE + v] is the pair (a * tile + u, b * tile + v).
+static void crossProductTile(const std::vector<std::vector<double>>& columns, const ColumnMoments& m, const size_t a, const size_t b, double* out)
+{
+    const size_t T = CORRELATION_TILE, B = CORRELATION_ROWS, p = columns.size();
+    size_t a0 = a * T, na = std::min(p, a0 + T) - a0;
+    size_t b0 = b * T, nb = std::min(p, b0 + T) - b0;
+
+    thread_local std::vector<double> buffer;
+    buffer.resize(2 * T * B);
+    double* ta = buffer.data();
+    double* tb = (a == b) ? ta : buffer.data() + T * B;
+
+    std::fill(out, out + T * T, 0.);
+
+    for (size_t r0 = 0; r0 < m.n; r0 += B)
+    {
+        size_t rows = std::min(m.n, r0 + B) - r0;
+
+        auto center = [&](double* tile, size_t c0, size_t nc)
+        {
+            for (size_t u = 0; u < nc; u++)
+            {
+                const double* x = columns[c0 + u].data() + r0;
+                double mu = m.mean[c0 + u];
+                for (size_t i = 0; i < rows; i++)
+                    tile[u * B + i] = x[i] - mu;
+            }
+        };
+        center(ta, a0, na);
+        if (a != b)
+            center(tb, b0, nb);
+
+        for (size_t u = 0; u < na; u++)
+        {
+            // Upper triangle only on a diagonal tile.
+            size_t v0 = (a == b) ? u : 0;
+            for (size_t v = v0; v < nb; v += 4)
+            {
+                const double* y4[4];
+                double dots[4];
+
+                for (size_t q = 0; q < 4; q++)
+                    y4[q] = tb + std::min(v + q, nb - 1) * B;
+                simdDot4(ta + u * B, y4, rows, dots);
+                for (size_t q = 0; q < 4 && v + q < nb; q++)
+                    out[u * T + v + q] += dots[q];
+            }
+        }
+    }
+
+    for (size_t u = 0; u < na; u++)
+        for (size_t v = 0; v < nb; v++)
+            out[u * T + v] -= m.s1[a0 + u] * m.s1[b0 + v] / m.n;
+}
+
+// Calls tile(a, b, products) for every tile pair a <= b, in parallel for large inputs.
+template<typename TileFn>
+static void forEachTile(const std::vector<std::vector<double>>& columns, const ColumnMoments& m, TileFn tile)
+{
+    size_t tiles = (columns.size() + CORRELATION_TILE - 1) / CORRELATION_TILE;
+    std::vector<std::pair<size_t, size_t>> pairs;
+
+    for (size_t a = 0; a < tiles; a++)
+        for (size_t b = a; b < tiles; b++)
+            pairs.emplace_back(a, b);
+
+    auto run = [&](size_t t)
+    {
+        thread_local std::vector<double> products;
+        products.resize(CORRELATION_TILE * CORRELATION_TILE);
+        crossProductTile(columns, m, pairs[t].first, pairs[t].second, products.data());
+        tile(t, pairs[t].first, pairs[t].second, products.data());
+    };
+
+    if (m.n * columns.size() < parallelThreshold())
+        for (size_t t = 0; t < pairs.size(); t++)
+            run(t);
+    else
+        threadPool().run(pairs.size(), run);
+}
+
+// Fill the p x p matrix from the tiles, f(products, i, j) gives element (i, j).
+template<typename ElementFn>
+static std::vector<double> pairMatrix(const std::vector<std::vector<double>>& columns, const ColumnMoments& m, ElementFn f)
+{
+    const size_t T = CORRELATION_TILE, p = columns.size();
+    std::vector<double> matrix(p * p);
+
+    forEachTile(columns, m, [&](size_t, size_t a, size_t b, const double* products)
+    {
+        for (size_t u = 0; u < T && a * T + u < p; u++)
+            for (size_t v = (a == b) ? u : 0; v < T && b * T + v < p; v++)
+            {
+                size_t i = a * T + u, j = b * T + v;
+                matrix[i * p + j] = matrix[j * p + i] = f(products[u * T + v], i, j);
+            }
+    });
+
+    return matrix;
+}
+
+// Sample covariance of every pair of columns.
+std::vector<double> covarianceMatrix(const std::vector<std::vector<double>>& columns)
+{
+    ColumnMoments m = columnMoments(columns);
+    double divisor = double(m.n) - 1.;
+
+    return pairMatrix(columns, m, [divisor](double sxy, size_t, size_t) { return sxy / divisor; });
+}
+
+// Pearson r of columns i and j from their centered cross product sxy, clamped to [-1, 1]. A column
+// whose sum of squares is within the rounding of its mean (x - mean is then a few ulps, not 0) has
+// no variance, and every r with it is NAN.
+static double pearsonR(const ColumnMoments& m, const double sxy, const size_t i, const size_t j)
+{
+    auto constant = [&m](size_t c) { double e = 4. * DBL_EPSILON * m.mean[c]; return m.ss[c] <= m.n * e * e; };
+
+    if (constant(i) || constant(j))
+        return NAN;
+    if (i == j)
+        return 1.;
+
+    return fmax2(-1., fmin2(1., sxy / sqrt(m.ss[i] * m.ss[j])));
+}
+
+// Pearson correlation of every pair of columns (NAN for a constant column).
+std::vector<double> correlationMatrix(const std::vector<std::vector<double>>& columns)
+{
+    ColumnMoments m = columnMoments(columns);
+
+    return pairMatrix(columns, m, [&m](double sxy, size_t i, size_t j) { return pearsonR(m, sxy, i, j); });
+}
+
+// The k column pairs with the largest |r|, ordered by |r| then by (i, j).
+std::vector<CorrelationPair> topCorrelations(const std::vector<std::vector<double>>& columns, const size_t k)
+{
+    const size_t T = CORRELATION_TILE, p = columns.size();
+    ColumnMoments m = columnMoments(columns);
+    size_t tiles = (p + T - 1) / T;
+    std::vector<std::vector<CorrelationPair>> best(tiles * (tiles + 1) / 2);
+
+    auto stronger = [](const CorrelationPair& x, const CorrelationPair& y)
+    {
+        double ax = fabs(x.r), ay = fabs(y.r);
+        return (ax != ay) ? ax > ay : (x.i != y.i) ? x.i < y.i : x.j < y.j;
+    };
+
+    if (k == 0)
+        return { };
+
+    // Each tile keeps a heap of its k strongest pairs (weakest on top).
+    forEachTile(columns, m, [&](size_t t, size_t a, size_t b, const double* products)
+    {
+        std::vector<CorrelationPair>& heap = best[t];
+
+        for (size_t u = 0; u < T && a * T + u < p; u++)
+            for (size_t v = (a == b) ? u + 1 : 0; v < T && b * T + v < p; v++)
+            {
+                size_t i = a * T + u, j = b * T + v;
+                CorrelationPair c{ i, j, pearsonR(m, products[u * T + v], i, j) };
+
+                if (isnan(c.r))
+                    continue;
+                if (heap.size() < k)
+                {
+                    heap.push_back(c);
+                    std::push_heap(heap.begin(), heap.end(), stronger);
+                }
+                else if (stronger(c, heap.front()))
+                {
+                    std::pop_heap(heap.begin(), heap.end(), stronger);
+                    heap.back() = c;
+                    std::push_heap(heap.begin(), heap.end(), stronger);
+                }
+            }
+    });
+
+    std::vector<CorrelationPair> top;
+    for (auto& h : best)
+        top.insert(top.end(), h.begin(), h.end());
+
+    size_t keep = std::min(k, top.size());
+    std::partial_sort(top.begin(), top.begin() + keep, top.end(), stronger);
+    top.resize(keep);
+
+    return top;
+}
+
+// Estimate, test statistic and 2-tailed p-value of a correlation test.
+struct CorrelationTest
+{
+    double r;
+    double statistic;
+    double pValue;
+};
+
+// Ranks 1..n of the data, tied values share the average of their ranks.
+std::vector<double> ranks(const std::vector<double>& x)
+{
+    size_t n = x.size();
+    std::vector<std::pair<double, size_t>> sorted(n);
+    std::vector<double> rank(n);
+
+    for (size_t i = 0; i < n; i++)
+        sorted[i] = std::make_pair(x[i], i);
+    parallelSort(sorted.begin(), sorted.end(), [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first < b.first; });
+
+    for (size_t i = 0; i < n; )
+    {
+        size_t j = i + 1;
+        while (j < n && sorted[j].first == sorted[i].first)
+            j++;
+
+        double average = (i + 1 + j) / 2.;
+        for (size_t q = i; q < j; q++)
+            rank[sorted[q].second] = average;
+        i = j;
+    }
+
+    return rank;
+}
+
+// Spearman's rank correlation rho.
+CorrelationTest spearman(const std::vector<double>& x, const std::vector<double>& y)
+{
+    assert(x.size() == y.size() && x.size() > 2);
+
+    double rho = R(ranks(x), ranks(y));
+    unsigned df = unsigned(x.size() - 2);
+    double t = rho * sqrt(df / (1. - rho * rho));
+
+    return { rho, t, 2. * pt(-fabs(t), df) };
+}
+
+// Sum of t(t - 1) / 2 over runs of equal values in sorted data, and the two sums the variance
+// of S needs: t(t - 1)(2t + 5) and t(t - 1)(t - 2), plus t(t - 1).
+struct TieSums
+{
+    double pairs = 0., v = 0., v2 = 0., v1 = 0.;
+
+    void add(const double t)
+    {
+        pairs += t * (t - 1.) / 2.;
+        v += t * (t - 1.) * (2. * t + 5.);
+        v1 += t * (t - 1.);
+        v2 += t * (t - 1.) * (t - 2.);
+    }
+};
+
+template<typename T, typename Equal>
+static TieSums tieSums(const std::vector<T>& sorted, Equal equal)
+{
+    TieSums s;
+
+    for (size_t i = 0; i < sorted.size(); )
+    {
+        size_t j = i + 1;
+        while (j < sorted.size() && equal(sorted[j], sorted[i]))
+            j++;
+        if (j - i > 1)
+            s.add(double(j - i));
+        i = j;
+    }
+
+    return s;
+}
+
+// Bottom-up merge sort of y counting the exchanges, i.e. the pairs i < j with y[i] > y[j].
+// The merges of each width are independent and run on the pool.
+static double mergeSortSwaps(std::vector<double>& y)
+{
+    size_t n = y.size();
+    std::vector<double> buffer(n);
+    double swaps = 0.;
+
+    for (size_t width = 1; width < n; width *= 2)
+    {
+        size_t merges = (n + 2 * width - 1) / (2 * width);
+        std::vector<double> count(merges);
+
+        auto merge = [&](size_t m)
+        {
+            size_t lo = 2 * m * width, mid = std::min(n, lo + width), hi = std::min(n, lo + 2 * width);
+            size_t i = lo, j = mid, out = lo;
+            double c = 0.;
+
+            while (i < mid && j < hi)
+            {
+                if (y[j] < y[i])
+                {
+                    c += double(mid - i);
+                    buffer[out++] = y[j++];
+                }
+                else
+                    buffer[out++] = y[i++];
+            }
+            std::copy(y.begin() + i, y.begin() + mid, buffer.begin() + out);
+            std::copy(y.begin() + j, y.begin() + hi, buffer.begin() + out + (mid - i));
+            count[m] = c;
+        };
+
+        if (n < parallelThreshold() || merges < 2)
+            for (size_t m = 0; m < merges; m++)
+                merge(m);
+        else
+            threadPool().run(merges, merge);
+
+        y.swap(buffer);
+        for (double c : count)
+            swaps += c;
+    }
+
+    return swaps;
+}
+
+// Kendall's rank correlation tau-b, Knight's O(n log n) algorithm.
+CorrelationTest kendall(const std::vector<double>& x, const std::vector<double>& y)
+{
+    assert(x.size() == y.size() && x.size() > 2);
+
+    size_t n = x.size();
+    std::vector<std::pair<double, double>> xy(n);
+
+    for (size_t i = 0; i < n; i++)
+        xy[i] = std::make_pair(x[i], y[i]);
+
+    // Sort by x then y: ties in x are already in y order, so the swaps below are discordant pairs.
+    parallelSort(xy.begin(), xy.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a < b; });
+
+    TieSums tx = tieSums(xy, [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.first == b.first; });
+    TieSums txy = tieSums(xy, [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a == b; });
+
+    std::vector<double> ys(n);
+    for (size_t i = 0; i < n; i++)
+        ys[i] = xy[i].second;
+    double swaps = mergeSortSwaps(ys);
+    TieSums ty = tieSums(ys, [](double a, double b) { return a == b; });
+
+    double n0 = n * (n - 1.) / 2.;
+    double S = n0 - tx.pairs - ty.pairs + txy.pairs - 2. * swaps;
+    double tau = S / sqrt((n0 - tx.pairs) * (n0 - ty.pairs));
+
+    double N = double(n);
+    double var = (N * (N - 1.) * (2. * N + 5.) - tx.v - ty.v) / 18.
+        + tx.v1 * ty.v1 / (2. * N * (N - 1.))
+        + tx.v2 * ty.v2 / (9. * N * (N - 1.) * (N - 2.));
+    double z = S / sqrt(var);
+
+    return { tau, z, 2. * pNorm(-fabs(z), 0., 1.) };
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef ERF_H
 #define ERF_H
 
+#include <bit>
 #include "common.h"
 
 /**
@@ -204,13 +205,25 @@ sb5 = 2.55305040643316442583e+03,  /* 0x40A3F219, 0xCEDF3BE6 */
 sb6 = 4.74528541206955367215e+02,  /* 0x407DA874, 0xE79FE763 */
 sb7 = -2.24409524465858183362e+01; /* 0xC03670E2, 0x42712D62 */
 
+// High 32-bit word of a double (sign, exponent and top of the mantissa), and x with the low word
+// cleared. std::bit_cast rather than reading through an int pointer, which is undefined behavior
+// and keeps the compiler from vectorizing callers.
+static inline int32_t highWord(const double x)
+{
+	return int32_t(uint32_t(std::bit_cast<uint64_t>(x) >> 32));
+}
+
+static inline double clearLowWord(const double x)
+{
+	return std::bit_cast<double>(std::bit_cast<uint64_t>(x) & 0xffffffff00000000ULL);
+}
+
 double _erfc(double x)
 {
-	int n0, hx, ix;
+	int hx, ix;
 	double R, S, P, Q, s, y, z, r;
 
-	n0 = ((*(int*)&one) >> 29)^1;
-	hx = *(n0 + (int*)&x);
+	hx = highWord(x);
 	ix = hx & 0x7fffffff;
 
 	if (ix >= 0x7ff00000)    // erfc(nan) = nan 
@@ -272,8 +285,7 @@ double _erfc(double x)
 			R = rb0 + s * (rb1 + s * (rb2 + s * (rb3 + s * (rb4 + s * (rb5 + s * rb6)))));
 			S = one + s * (sb1 + s * (sb2 + s * (sb3 + s * (sb4 + s * (sb5 + s * (sb6 + s * sb7))))));
 		}
-		z = x;
-		*(1 - n0 + (int*)&z) = 0;
+		z = clearLowWord(x);
 		r = exp(-z * z - 0.5625) * exp((z - x) * (z + x) + R / S);
 		if (hx > 0)
 			return r / x; 
@@ -289,16 +301,63 @@ double _erfc(double x)
 	}
 }
 
+// Scaled complementary error function exp(x^2) erfc(x), x >= 0. Above 1.25 it is _erfc without its
+// exp(-x^2) factor, so it never underflows and log(erfc(x)) = log(_erfcx(x)) - x^2 for any x.
+double _erfcx(double x)
+{
+	double R, S, s;
+	int ix = highWord(x) & 0x7fffffff;
+
+	if (ix < 0x3ff40000)     // |x| < 1.25
+		return exp(x * x) * _erfc(x);
+
+	s = one / (x * x);
+	if (ix < 0x4006DB6D)     // |x| < 1/.35 ~ 2.857143
+	{
+		R = ra0 + s * (ra1 + s * (ra2 + s * (ra3 + s * (ra4 + s * (ra5 + s * (ra6 + s * ra7))))));
+		S = one + s * (sa1 + s * (sa2 + s * (sa3 + s * (sa4 + s * (sa5 + s * (sa6 + s * (sa7 + s * sa8)))))));
+	}
+	else                     // the rb/sb fit holds as s -> 0, well past 28
+	{
+		R = rb0 + s * (rb1 + s * (rb2 + s * (rb3 + s * (rb4 + s * (rb5 + s * rb6)))));
+		S = one + s * (sb1 + s * (sb2 + s * (sb3 + s * (sb4 + s * (sb5 + s * (sb6 + s * sb7))))));
+	}
+
+	return exp(-0.5625 + R / S) / x;
+}
+
+// erf(x) for |x| < 0.84375, with full relative accuracy where 1 - _erfc(x) would cancel.
+double _erfSmall(double x)
+{
+	double r, s, z;
+	int ix = highWord(x) & 0x7fffffff;
+
+	if (ix < 0x3e300000)     // |x|<2**-28 
+	{
+		if (ix < 0x00800000) // avoid underflow 
+			return 0.125 * (8.0 * x + efx8 * x);
+		return x + efx * x;
+	}
+	z = x * x;
+	r = pp0 + z * (pp1 + z * (pp2 + z * (pp3 + z * pp4)));
+	s = one + z * (qq1 + z * (qq2 + z * (qq3 + z * (qq4 + z * qq5))));
+
+	return x + x * (r / s);
+}
+
+// Acklam's rational approximation to the normal quantile (relative error < 1.15e-9).
+static const double
+ack_a1 = -39.6968302866538, ack_a2 = 220.946098424521, ack_a3 = -275.928510446969,
+ack_a4 = 138.357751867269, ack_a5 = -30.6647980661472, ack_a6 = 2.50662827745924,
+ack_b1 = -54.4760987982241, ack_b2 = 161.585836858041, ack_b3 = -155.698979859887,
+ack_b4 = 66.8013118877197, ack_b5 = -13.2806815528857, ack_c1 = -7.78489400243029E-03,
+ack_c2 = -0.322396458041136, ack_c3 = -2.40075827716184, ack_c4 = -2.54973253934373,
+ack_c5 = 4.37466414146497, ack_c6 = 2.93816398269878, ack_d1 = 7.78469570904146E-03,
+ack_d2 = 0.32246712907004, ack_d3 = 2.445134137143, ack_d4 = 3.75440866190742,
+ack_p_low = 0.02425, ack_p_high = 1. - ack_p_low;
+
 double _erf(double p)
 {
-	double a1 = -39.6968302866538, a2 = 220.946098424521, a3 = -275.928510446969;
-	double a4 = 138.357751867269, a5 = -30.6647980661472, a6 = 2.50662827745924;
-	double b1 = -54.4760987982241, b2 = 161.585836858041, b3 = -155.698979859887;
-	double b4 = 66.8013118877197, b5 = -13.2806815528857, c1 = -7.78489400243029E-03;
-	double c2 = -0.322396458041136, c3 = -2.40075827716184, c4 = -2.54973253934373;
-	double c5 = 4.37466414146497, c6 = 2.93816398269878, d1 = 7.78469570904146E-03;
-	double d2 = 0.32246712907004, d3 = 2.445134137143, d4 = 3.75440866190742;
-	double p_low = 0.02425, p_high = 1. - p_low;
 	double q, r, retVal;
 
 	if ((p < 0.) || (p > 1.))
@@ -306,24 +365,155 @@ double _erf(double p)
 		// Argument out of range.
 		retVal = 0.;
 	}
-	else if (p < p_low)
+	else if (p == 0. || p == 1.)
+	{
+		retVal = (p == 0.) ? ML_NEGINF : ML_POSINF;
+	}
+	else if (p < ack_p_low)
 	{
 		q = sqrt(-2. * log(p));
-		retVal = (((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1.);
+		retVal = (((((ack_c1 * q + ack_c2) * q + ack_c3) * q + ack_c4) * q + ack_c5) * q + ack_c6) / ((((ack_d1 * q + ack_d2) * q + ack_d3) * q + ack_d4) * q + 1.);
 	}
-	else if (p <= p_high)
+	else if (p <= ack_p_high)
 	{
 		q = p - 0.5;
 		r = q * q;
-		retVal = (((((a1 * r + a2) * r + a3) * r + a4) * r + a5) * r + a6) * q / (((((b1 * r + b2) * r + b3) * r + b4) * r + b5) * r + 1.);
+		retVal = (((((ack_a1 * r + ack_a2) * r + ack_a3) * r + ack_a4) * r + ack_a5) * r + ack_a6) * q / (((((ack_b1 * r + ack_b2) * r + ack_b3) * r + ack_b4) * r + ack_b5) * r + 1.);
 	}
 	else
 	{
 		q = sqrt(-2. * log(1. - p));
-		retVal = -(((((c1 * q + c2) * q + c3) * q + c4) * q + c5) * q + c6) / ((((d1 * q + d2) * q + d3) * q + d4) * q + 1.);
+		retVal = -(((((ack_c1 * q + ack_c2) * q + ack_c3) * q + ack_c4) * q + ack_c5) * q + ack_c6) / ((((ack_d1 * q + ack_d2) * q + ack_d3) * q + ack_d4) * q + 1.);
 	}
 
 	return retVal;
 }
 
+#ifdef SIMD_X86
+
+// Lane-wise _erfc and _erf for the batch normal functions, from the operations of simd.h.
+#define ERF_KERNELS(ISA, TARGET)                                                                       \
+/* erfc(x) per lane. Every range of _erfc is evaluated and the results blended, with one     */        \
+/* test per vector to skip the exp range when no lane needs it. Results below 2^-1021 flush  */        \
+/* to zero (|x| > 26.6), where _erfc is subnormal.                                           */        \
+SIMD_TARGET(TARGET) static inline V_##ISA erfcv_##ISA(V_##ISA x)                                       \
+{                                                                                                      \
+    V_##ISA ax = V_ABS_##ISA(x);                                                                       \
+    VM_##ISA neg = V_LT_##ISA(x, V_ZERO_##ISA());                                                      \
+                                                                                                       \
+    /* |x| < 0.84375: 1 - (x + x R(x^2)), or 1/2 - (x R + (x - 1/2)) from 1/4 */                       \
+    V_##ISA z = V_MUL_##ISA(x, x);                                                                     \
+    V_##ISA r = V_ADD_##ISA(V_SET1_##ISA(pp3), V_MUL_##ISA(z, V_SET1_##ISA(pp4)));                     \
+    r = V_ADD_##ISA(V_SET1_##ISA(pp2), V_MUL_##ISA(z, r));                                             \
+    r = V_ADD_##ISA(V_SET1_##ISA(pp1), V_MUL_##ISA(z, r));                                             \
+    r = V_ADD_##ISA(V_SET1_##ISA(pp0), V_MUL_##ISA(z, r));                                             \
+    V_##ISA s = V_ADD_##ISA(V_SET1_##ISA(qq4), V_MUL_##ISA(z, V_SET1_##ISA(qq5)));                     \
+    s = V_ADD_##ISA(V_SET1_##ISA(qq3), V_MUL_##ISA(z, s));                                             \
+    s = V_ADD_##ISA(V_SET1_##ISA(qq2), V_MUL_##ISA(z, s));                                             \
+    s = V_ADD_##ISA(V_SET1_##ISA(qq1), V_MUL_##ISA(z, s));                                             \
+    s = V_ADD_##ISA(V_SET1_##ISA(one), V_MUL_##ISA(z, s));                                             \
+    V_##ISA xy = V_MUL_##ISA(x, V_DIV_##ISA(r, s));                                                    \
+    V_##ISA small = V_BLEND_##ISA(V_LT_##ISA(x, V_SET1_##ISA(0.25)), V_SUB_##ISA(V_SET1_##ISA(half), V_ADD_##ISA(xy, V_SUB_##ISA(x, V_SET1_##ISA(half)))), V_SUB_##ISA(V_SET1_##ISA(one), V_ADD_##ISA(x, xy))); \
+                                                                                                       \
+    /* 0.84375 <= |x| < 1.25: (1 - erx) - P/Q, or 1 + (erx + P/Q) for x < 0 */                         \
+    s = V_SUB_##ISA(ax, V_SET1_##ISA(one));                                                            \
+    V_##ISA P = V_ADD_##ISA(V_SET1_##ISA(pa5), V_MUL_##ISA(s, V_SET1_##ISA(pa6)));                     \
+    P = V_ADD_##ISA(V_SET1_##ISA(pa4), V_MUL_##ISA(s, P));                                             \
+    P = V_ADD_##ISA(V_SET1_##ISA(pa3), V_MUL_##ISA(s, P));                                             \
+    P = V_ADD_##ISA(V_SET1_##ISA(pa2), V_MUL_##ISA(s, P));                                             \
+    P = V_ADD_##ISA(V_SET1_##ISA(pa1), V_MUL_##ISA(s, P));                                             \
+    P = V_ADD_##ISA(V_SET1_##ISA(pa0), V_MUL_##ISA(s, P));                                             \
+    V_##ISA Q = V_ADD_##ISA(V_SET1_##ISA(qa5), V_MUL_##ISA(s, V_SET1_##ISA(qa6)));                     \
+    Q = V_ADD_##ISA(V_SET1_##ISA(qa4), V_MUL_##ISA(s, Q));                                             \
+    Q = V_ADD_##ISA(V_SET1_##ISA(qa3), V_MUL_##ISA(s, Q));                                             \
+    Q = V_ADD_##ISA(V_SET1_##ISA(qa2), V_MUL_##ISA(s, Q));                                             \
+    Q = V_ADD_##ISA(V_SET1_##ISA(qa1), V_MUL_##ISA(s, Q));                                             \
+    Q = V_ADD_##ISA(V_SET1_##ISA(one), V_MUL_##ISA(s, Q));                                             \
+    V_##ISA pq = V_DIV_##ISA(P, Q);                                                                    \
+    V_##ISA res = V_BLEND_##ISA(neg, V_SUB_##ISA(V_SET1_##ISA(one - erx), pq), V_ADD_##ISA(V_SET1_##ISA(one), V_ADD_##ISA(V_SET1_##ISA(erx), pq))); \
+                                                                                                       \
+    /* 1.25 <= |x| < 28: exp(-x^2 - 0.5625 + R/S) / |x| with R, S in 1/x^2 from the [1.25, 1/0.35) */  \
+    /* or the [1/0.35, 28) coefficients, 2 - that for x < 0; 0 or 2 from 28 */                         \
+    if (V_ANY_##ISA(V_LE_##ISA(V_SET1_##ISA(1.25), ax)))                                               \
+    {                                                                                                  \
+        VM_##ISA near = V_LT_##ISA(ax, V_SET1_##ISA(2.85714244842529296875));                          \
+        s = V_DIV_##ISA(V_SET1_##ISA(one), V_MUL_##ISA(ax, ax));                                       \
+        V_##ISA R = V_BLEND_##ISA(near, V_ZERO_##ISA(), V_SET1_##ISA(ra7));                            \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb6), V_SET1_##ISA(ra6)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb5), V_SET1_##ISA(ra5)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb4), V_SET1_##ISA(ra4)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb3), V_SET1_##ISA(ra3)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb2), V_SET1_##ISA(ra2)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb1), V_SET1_##ISA(ra1)), V_MUL_##ISA(s, R)); \
+        R = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(rb0), V_SET1_##ISA(ra0)), V_MUL_##ISA(s, R)); \
+        V_##ISA S = V_BLEND_##ISA(near, V_ZERO_##ISA(), V_SET1_##ISA(sa8));                            \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb7), V_SET1_##ISA(sa7)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb6), V_SET1_##ISA(sa6)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb5), V_SET1_##ISA(sa5)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb4), V_SET1_##ISA(sa4)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb3), V_SET1_##ISA(sa3)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb2), V_SET1_##ISA(sa2)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_BLEND_##ISA(near, V_SET1_##ISA(sb1), V_SET1_##ISA(sa1)), V_MUL_##ISA(s, S)); \
+        S = V_ADD_##ISA(V_SET1_##ISA(one), V_MUL_##ISA(s, S));                                         \
+        V_##ISA zt = V_ASDBL_##ISA(I_AND_##ISA(V_ASINT_##ISA(ax), I_SET1_##ISA(0xffffffff00000000ULL))); \
+        V_##ISA e = V_MUL_##ISA(vexp_##ISA(V_SUB_##ISA(V_SET1_##ISA(-0.5625), V_MUL_##ISA(zt, zt))), vexp_##ISA(V_ADD_##ISA(V_MUL_##ISA(V_SUB_##ISA(zt, ax), V_ADD_##ISA(zt, ax)), V_DIV_##ISA(R, S)))); \
+        V_##ISA far = V_BLEND_##ISA(V_LT_##ISA(ax, V_SET1_##ISA(28.)), V_ZERO_##ISA(), V_DIV_##ISA(e, ax)); \
+        far = V_BLEND_##ISA(neg, far, V_SUB_##ISA(V_SET1_##ISA(two), far));                            \
+        res = V_BLEND_##ISA(V_LT_##ISA(ax, V_SET1_##ISA(1.25)), far, res);                             \
+    }                                                                                                  \
+                                                                                                       \
+    res = V_BLEND_##ISA(V_LT_##ISA(ax, V_SET1_##ISA(0.84375)), res, small);                            \
+    return V_BLEND_##ISA(V_ISNAN_##ISA(x), res, x);                                                    \
+}                                                                                                      \
+                                                                                                       \
+/* _erf (Acklam's normal quantile) per lane for 0 < p < 1; the log of the tails is only     */         \
+/* evaluated when some lane is in a tail.                                                    */        \
+SIMD_TARGET(TARGET) static inline V_##ISA acklamv_##ISA(V_##ISA p)                                     \
+{                                                                                                      \
+    V_##ISA q = V_SUB_##ISA(p, V_SET1_##ISA(0.5)), r = V_MUL_##ISA(q, q);                              \
+    V_##ISA num = V_ADD_##ISA(V_MUL_##ISA(V_SET1_##ISA(ack_a1), r), V_SET1_##ISA(ack_a2));             \
+    num = V_ADD_##ISA(V_MUL_##ISA(num, r), V_SET1_##ISA(ack_a3));                                      \
+    num = V_ADD_##ISA(V_MUL_##ISA(num, r), V_SET1_##ISA(ack_a4));                                      \
+    num = V_ADD_##ISA(V_MUL_##ISA(num, r), V_SET1_##ISA(ack_a5));                                      \
+    num = V_ADD_##ISA(V_MUL_##ISA(num, r), V_SET1_##ISA(ack_a6));                                      \
+    V_##ISA den = V_ADD_##ISA(V_MUL_##ISA(V_SET1_##ISA(ack_b1), r), V_SET1_##ISA(ack_b2));             \
+    den = V_ADD_##ISA(V_MUL_##ISA(den, r), V_SET1_##ISA(ack_b3));                                      \
+    den = V_ADD_##ISA(V_MUL_##ISA(den, r), V_SET1_##ISA(ack_b4));                                      \
+    den = V_ADD_##ISA(V_MUL_##ISA(den, r), V_SET1_##ISA(ack_b5));                                      \
+    den = V_ADD_##ISA(V_MUL_##ISA(den, r), V_SET1_##ISA(1.));                                          \
+    V_##ISA res = V_DIV_##ISA(V_MUL_##ISA(num, q), den);                                               \
+                                                                                                       \
+    VM_##ISA lower = V_LT_##ISA(p, V_SET1_##ISA(ack_p_low)), upper = V_LT_##ISA(V_SET1_##ISA(ack_p_high), p); \
+    if (V_ANY_##ISA(lower) || V_ANY_##ISA(upper))                                                      \
+    {                                                                                                  \
+        V_##ISA t = V_BLEND_##ISA(upper, p, V_SUB_##ISA(V_SET1_##ISA(1.), p));                         \
+        t = V_BLEND_##ISA(V_LE_##ISA(t, V_ZERO_##ISA()), t, V_SET1_##ISA(0.5)); /* log of a lane outside (0, 1) is not used */ \
+        q = V_SQRT_##ISA(V_MUL_##ISA(V_SET1_##ISA(-2.), vlog_##ISA(t)));                               \
+        num = V_ADD_##ISA(V_MUL_##ISA(V_SET1_##ISA(ack_c1), q), V_SET1_##ISA(ack_c2));                 \
+        num = V_ADD_##ISA(V_MUL_##ISA(num, q), V_SET1_##ISA(ack_c3));                                  \
+        num = V_ADD_##ISA(V_MUL_##ISA(num, q), V_SET1_##ISA(ack_c4));                                  \
+        num = V_ADD_##ISA(V_MUL_##ISA(num, q), V_SET1_##ISA(ack_c5));                                  \
+        num = V_ADD_##ISA(V_MUL_##ISA(num, q), V_SET1_##ISA(ack_c6));                                  \
+        den = V_ADD_##ISA(V_MUL_##ISA(V_SET1_##ISA(ack_d1), q), V_SET1_##ISA(ack_d2));                 \
+        den = V_ADD_##ISA(V_MUL_##ISA(den, q), V_SET1_##ISA(ack_d3));                                  \
+        den = V_ADD_##ISA(V_MUL_##ISA(den, q), V_SET1_##ISA(ack_d4));                                  \
+        den = V_ADD_##ISA(V_MUL_##ISA(den, q), V_SET1_##ISA(1.));                                      \
+        V_##ISA tail = V_DIV_##ISA(num, den);                                                          \
+        res = V_BLEND_##ISA(lower, res, tail);                                                         \
+        res = V_BLEND_##ISA(upper, res, V_SUB_##ISA(V_ZERO_##ISA(), tail));                            \
+    }                                                                                                  \
+                                                                                                       \
+    return res;                                                                                        \
+}
+
+SIMD_NO_CONTRACT_BEGIN
+ERF_KERNELS(SSE2, "sse2")
+ERF_KERNELS(AVX2, "avx2")
+ERF_KERNELS(AVX512, "avx512f")
+SIMD_NO_CONTRACT_END
+
+#undef ERF_KERNELS
+
+#endif
+
 #endif
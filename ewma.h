@@ -0,0 +1,83 @@
+#ifndef EWMA_H
+#define EWMA_H
+
+#include "common.h"
+
+/*
+  Exponentially-weighted statistics
+  Mean, variance and z-score of a stream where each sample's weight halves every half-life.
+  Timestamps may be irregular: a sample observed dt after the previous one decays the old
+  weight by 2^(-dt / halfLife). The state of a series is four doubles and each update is O(1),
+  so millions of series can be tracked at once. The decay is passed to each update rather
+  than stored per series.
+     mean     = sum(w[i] * x[i]) / sum(w[i]),  w[i] = 2^(-(t - t[i]) / halfLife)
+     variance = sum(w[i] * (x[i] - mean)^2) / sum(w[i])
+  Usage:
+     EWDecay decay(halfLife);
+     EWStats s;  s.push(x, t, decay);   (or s.push(x, decay) for evenly spaced samples)
+     s.mean(); s.variance(); s.standardDeviation(); s.zScore(x);
+*/
+
+// Decay for a half-life, in the units of the timestamps (samples when untimed).
+struct EWDecay
+{
+    double halfLife;
+    double perSample; // decay across one sample interval
+
+    explicit EWDecay(const double halfLife) : halfLife(halfLife), perSample(exp2(-1. / halfLife)) { }
+
+    // Factor applied to existing weight after dt has elapsed.
+    double factor(const double dt) const
+    {
+        return (dt <= 0.) ? 1. : exp2(-dt / halfLife);
+    }
+};
+
+// Exponentially-weighted mean and variance of one series.
+class EWStats
+{
+public:
+    // Add sample x observed at time t (out of order or repeated times get no extra decay).
+    void push(const double x, const double t, const EWDecay& decay)
+    {
+        update(x, isnan(time) ? 0. : decay.factor(t - time));
+        time = isnan(time) ? t : fmax2(time, t);
+    }
+
+    // Add sample x, one sample interval after the previous one.
+    void push(const double x, const EWDecay& decay)
+    {
+        update(x, decay.perSample);
+    }
+
+    double mean() const { return mu; }
+    double variance() const { return var; }
+    double standardDeviation() const { return sqrt(var); }
+    // Total decayed weight, the effective number of samples.
+    double weight() const { return w; }
+
+    // Standard deviations of x from the weighted mean (score x before pushing it).
+    double zScore(const double x) const
+    {
+        return (x - mu) / sqrt(var);
+    }
+
+private:
+    double mu = 0.;
+    double var = 0.;
+    double w = 0.;
+    double time = NAN;
+
+    void update(const double x, const double decay)
+    {
+        w = w * decay + 1.;
+
+        double alpha = 1. / w;
+        double diff = x - mu;
+
+        mu += alpha * diff;
+        var = (1. - alpha) * (var + alpha * diff * diff);
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef NORMAL_H
 #define NORMAL_H
 
+#include <span>
 #include "common.h"
 #include "erf.h"
 
@@ -17,7 +18,11 @@
   Usage:
      dnorm(x, mean = 0, sd = 1)
      pnorm(q, mean = 0, sd = 1)
+     pnorm(q, mean, sd, lower_tail, log_p = false)
+     pNormTails(q, mean = 0, sd = 1)   lower and upper tail and their logs
      qnorm(p, mean = 0, sd = 1)
+     pNorm(x, out, mean = 0, sd = 1)   batch, out[i] = pNorm(x[i], mean, sd); likewise dNorm and qNorm
+     pNorm<Precision::Exact>(q, mean = 0, sd = 1)   precision tier Table, Fast, Standard or Exact; likewise dNorm and qNorm
   Arguments:
      x, q = quantile
      p = probability
@@ -29,20 +34,74 @@
 // Returns probability/percent/proportion/area under curve of normal distribution [0 to x].
 // If n > 30 can use normal distribution.
 // If n <= 30, then original population must be normal distribution.
-double pNorm(const double n, const double mu = 0., const double sdev = 1.)
+// In a constant expression the constexpr version of critical.h is evaluated instead.
+constexpr double pNorm(const double n, const double mu = 0., const double sdev = 1.)
 {
     double z = ((n - mu) / sdev);
+    if (std::is_constant_evaluated())
+        return cxPNorm(z);
     return _erfc(-z / sqrt(2.)) / 2.0;
 }
 
 // Returns x of given probability/percent/proportion/area under curve of normal distribution.
 // If n*p > 5 and n *(1 - p) > 5, then can use normal distribution.
-double qNorm(const double p, const double mu = 0., const double sdev = 1.)
+// At compile time the quantile is solved to full precision instead of Acklam's 1e-9.
+constexpr double qNorm(const double p, const double mu = 0., const double sdev = 1.)
 {
-    double z = _erf(p);
+    double z = std::is_constant_evaluated() ? cxQNorm(p) : _erf(p);
     return mu + (z * sdev);
 }
 
+// log of the smaller tail s = Phi(-u), u >= 0. Once s is below DBL_MIN (u > 37.5) the log is taken
+// from the scaled erfc, so it stays finite where s underflows.
+static double logPNormTail(const double u, const double s)
+{
+    if (s >= DBL_MIN)
+        return log(s);
+
+    double t = u / sqrt(2.);
+    return log(_erfcx(t) / 2.) - t * t;
+}
+
+// pnorm(q, mean, sd, lower.tail, log.p). The upper tail and the logs are computed directly rather than
+// as 1 - pNorm() or log(pNorm()), which are 0 or -inf past about 8 and 38 sigma.
+double pNorm(const double x, const double mu, const double sdev, const bool lower_tail, const bool log_p = false)
+{
+    double z = (x - mu) / sdev;
+
+    if (isnan(z))
+        return z;
+
+    double u = fabs(z), s = _erfc(u / sqrt(2.)) / 2.;
+
+    if ((z < 0.) == lower_tail)
+        return log_p ? logPNormTail(u, s) : s;
+
+    return log_p ? log1p(-s) : 1. - s;
+}
+
+// Both tails of the normal distribution and their logs, from a single erfc.
+struct NormalTails
+{
+    double lower = NAN, upper = NAN, logLower = NAN, logUpper = NAN;
+
+    // 2-tailed p-value.
+    double twoSided() const { return 2. * fmin(lower, upper); }
+};
+
+NormalTails pNormTails(const double x, const double mu = 0., const double sdev = 1.)
+{
+    double z = (x - mu) / sdev;
+
+    if (isnan(z))
+        return NormalTails();
+
+    double u = fabs(z), s = _erfc(u / sqrt(2.)) / 2.;
+    double ls = logPNormTail(u, s), b = 1. - s, lb = log1p(-s);
+
+    return (z < 0.) ? NormalTails{ s, b, ls, lb } : NormalTails{ b, s, lb, ls };
+}
+
 // Compute the density of the normal distribution.
 double dNorm(const double x, const double mu = 0., const double sigma = 1.)
 {
@@ -76,6 +135,160 @@ double dNorm(const double x, const double mu = 0., const double sigma = 1.)
   return M_1_SQRT_2PI * exp(-0.5 * x_ * x_) / sigma;
 }
 
+// Batch kernels, out[i] = f(x[i], mu, sd) for i < n.
+typedef void (*NormalKernel)(const double*, size_t, double, double, double*);
+
+static void pNorm_Scalar(const double* x, size_t n, double mu, double sd, double* out)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = pNorm(x[i], mu, sd);
+}
+
+static void dNorm_Scalar(const double* x, size_t n, double mu, double sd, double* out)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = dNorm(x[i], mu, sd);
+}
+
+static void qNorm_Scalar(const double* p, size_t n, double mu, double sd, double* out)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = qNorm(p[i], mu, sd);
+}
+
+#ifdef SIMD_X86
+
+// The same formulas as pNorm, dNorm and qNorm a vector at a time (erfcv, acklamv and vexp are
+// branch free). Built without FMA contraction, every lane is within 5 ulps of the scalar function
+// (vexp and vlog round differently from the libm exp and log) as long as the scalar
+// code is not contracted either, i.e. not built with -march flags enabling FMA under GCC's default
+// -ffp-contract=fast. Results below 2^-1021 flush to zero: pNorm for z < -37.5 and dNorm for
+// |z| > 37.5, where the scalar functions return subnormals.
+#define NORMAL_KERNELS(ISA, TARGET)                                                                    \
+SIMD_TARGET(TARGET) static inline V_##ISA pnormv_##ISA(V_##ISA x, V_##ISA mu, V_##ISA sd)              \
+{                                                                                                      \
+    V_##ISA z = V_DIV_##ISA(V_SUB_##ISA(x, mu), sd);                                                   \
+    return V_MUL_##ISA(erfcv_##ISA(V_DIV_##ISA(V_SUB_##ISA(V_ZERO_##ISA(), z), V_SET1_##ISA(M_SQRT2))), V_SET1_##ISA(0.5)); \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static inline V_##ISA dnormv_##ISA(V_##ISA x, V_##ISA mu, V_##ISA sd)              \
+{                                                                                                      \
+    V_##ISA z = V_ABS_##ISA(V_DIV_##ISA(V_SUB_##ISA(x, mu), sd));                                      \
+    return V_DIV_##ISA(V_MUL_##ISA(V_SET1_##ISA(M_1_SQRT_2PI), vexp_##ISA(V_MUL_##ISA(V_MUL_##ISA(V_SET1_##ISA(-0.5), z), z))), sd); \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static inline V_##ISA qnormv_##ISA(V_##ISA p, V_##ISA mu, V_##ISA sd)              \
+{                                                                                                      \
+    V_##ISA z = acklamv_##ISA(p);                                                                      \
+    z = V_BLEND_##ISA(V_LE_##ISA(p, V_ZERO_##ISA()), z, V_SET1_##ISA(ML_NEGINF));                      \
+    z = V_BLEND_##ISA(V_LE_##ISA(V_SET1_##ISA(1.), p), z, V_SET1_##ISA(ML_POSINF));                    \
+    z = V_BLEND_##ISA(V_LT_##ISA(p, V_ZERO_##ISA()), z, V_ZERO_##ISA());                               \
+    z = V_BLEND_##ISA(V_LT_##ISA(V_SET1_##ISA(1.), p), z, V_ZERO_##ISA());                             \
+    return V_ADD_##ISA(mu, V_MUL_##ISA(V_BLEND_##ISA(V_ISNAN_##ISA(p), z, p), sd));                    \
+}                                                                                                      \
+                                                                                                       \
+/* out[i] = f(x[i], mu, sd), the last partial vector through a padded copy. */                         \
+SIMD_TARGET(TARGET) static void pNorm_##ISA(const double* x, size_t n, double mu, double sd, double* out) \
+{                                                                                                      \
+    V_##ISA m = V_SET1_##ISA(mu), s = V_SET1_##ISA(sd);                                                \
+    double buf[W_##ISA] = { };                                                                         \
+    size_t i = 0;                                                                                      \
+                                                                                                       \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+        V_STORE_##ISA(out + i, pnormv_##ISA(V_LOAD_##ISA(x + i), m, s));                               \
+    if (i < n)                                                                                         \
+    {                                                                                                  \
+        std::copy(x + i, x + n, buf);                                                                  \
+        V_STORE_##ISA(buf, pnormv_##ISA(V_LOAD_##ISA(buf), m, s));                                     \
+        std::copy(buf, buf + (n - i), out + i);                                                        \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void dNorm_##ISA(const double* x, size_t n, double mu, double sd, double* out) \
+{                                                                                                      \
+    V_##ISA m = V_SET1_##ISA(mu), s = V_SET1_##ISA(sd);                                                \
+    double buf[W_##ISA] = { };                                                                         \
+    size_t i = 0;                                                                                      \
+                                                                                                       \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+        V_STORE_##ISA(out + i, dnormv_##ISA(V_LOAD_##ISA(x + i), m, s));                               \
+    if (i < n)                                                                                         \
+    {                                                                                                  \
+        std::copy(x + i, x + n, buf);                                                                  \
+        V_STORE_##ISA(buf, dnormv_##ISA(V_LOAD_##ISA(buf), m, s));                                     \
+        std::copy(buf, buf + (n - i), out + i);                                                        \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void qNorm_##ISA(const double* p, size_t n, double mu, double sd, double* out) \
+{                                                                                                      \
+    V_##ISA m = V_SET1_##ISA(mu), s = V_SET1_##ISA(sd);                                                \
+    double buf[W_##ISA] = { };                                                                         \
+    size_t i = 0;                                                                                      \
+                                                                                                       \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+        V_STORE_##ISA(out + i, qnormv_##ISA(V_LOAD_##ISA(p + i), m, s));                               \
+    if (i < n)                                                                                         \
+    {                                                                                                  \
+        std::fill(buf, buf + W_##ISA, 0.5);                                                            \
+        std::copy(p + i, p + n, buf);                                                                  \
+        V_STORE_##ISA(buf, qnormv_##ISA(V_LOAD_##ISA(buf), m, s));                                     \
+        std::copy(buf, buf + (n - i), out + i);                                                        \
+    }                                                                                                  \
+}
+
+SIMD_NO_CONTRACT_BEGIN
+NORMAL_KERNELS(SSE2, "sse2")
+NORMAL_KERNELS(AVX2, "avx2")
+NORMAL_KERNELS(AVX512, "avx512f")
+SIMD_NO_CONTRACT_END
+
+#undef NORMAL_KERNELS
+
+#endif
+
+struct NormalKernels
+{
+    NormalKernel p, d, q;
+};
+
+static NormalKernels normalKernels()
+{
+    switch (simdLevel())
+    {
+#ifdef SIMD_X86
+    case SimdLevel::AVX512: return { pNorm_AVX512, dNorm_AVX512, qNorm_AVX512 };
+    case SimdLevel::AVX2: return { pNorm_AVX2, dNorm_AVX2, qNorm_AVX2 };
+    case SimdLevel::SSE2: return { pNorm_SSE2, dNorm_SSE2, qNorm_SSE2 };
+#endif
+    default: return { pNorm_Scalar, dNorm_Scalar, qNorm_Scalar };
+    }
+}
+
+static void normalBatch(const NormalKernel kernel, std::span<const double> x, std::span<double> out, const double mu, const double sd)
+{
+    assert(out.size() >= x.size());
+    parallelFor(x.size(), [&](size_t begin, size_t end) { kernel(x.data() + begin, end - begin, mu, sd, out.data() + begin); });
+}
+
+// Batch forms: out[i] = pNorm(x[i], mu, sdev), etc. Vectorized, and split over the thread pool for
+// large arrays; out must hold at least x.size() values.
+void pNorm(std::span<const double> x, std::span<double> out, const double mu = 0., const double sdev = 1.)
+{
+    normalBatch(normalKernels().p, x, out, mu, sdev);
+}
+
+void qNorm(std::span<const double> p, std::span<double> out, const double mu = 0., const double sdev = 1.)
+{
+    normalBatch(normalKernels().q, p, out, mu, sdev);
+}
+
+void dNorm(std::span<const double> x, std::span<double> out, const double mu = 0., const double sigma = 1.)
+{
+    // Zero, negative and infinite sigma are special cases of dNorm.
+    normalBatch((sigma > 0. && isfinite(sigma)) ? normalKernels().d : dNorm_Scalar, x, out, mu, sigma);
+}
+
 // Cumulative normal distribution.
 double pNormCDF(double x)
 {
@@ -192,4 +405,226 @@ double qNormCDF(double p, double mu, double sigma)
     return mu + sigma * val;
 }
 
+// Precision tiers, chosen at compile time: pNorm<Precision::Fast>(x), qNorm<Precision::Exact>(p), ...
+// The untemplated pNorm, qNorm and dNorm are the Standard tier. Largest relative error seen against a
+// long double reference for |z| <= 38 and p in [1e-300, 1 - 1e-16], and time per call (one x86-64 core),
+// as reported by benchmark.cpp:
+//              pNorm                           qNorm                            dNorm
+//   Table      table         5e-14 abs 11 ns   table            8e-11    12 ns  as Fast
+//   Fast       A&S 7.1.26    7e-8 abs  16 ns   Acklam           2.2e-9   10 ns  no arg checks  6e-14  9 ns
+//   Standard   _erfc         2e-13     29 ns   Acklam           2.2e-9    9 ns  exp(-z^2 / 2)  6e-14  15 ns
+//   Exact      _erfc + d     4e-16     43 ns   Acklam + Halley  2.5e-16  84 ns  split z^2      4e-16  37 ns
+// Standard loses about z^2 ulps far in the tails (rounding of z / sqrt(2) and of z^2 / 2); Fast pNorm
+// and Table pNorm are only accurate in absolute terms. Table qNorm also takes no log in the tails (12 ns
+// there against Acklam's 20 ns). Fast qNorm is Acklam's approximation as well, which already
+// takes the log and sqrt only in the tails.
+enum class Precision { Table, Fast, Standard, Exact };
+
+template<Precision P> double pNorm(const double x, const double mu = 0., const double sdev = 1.)
+{
+    if constexpr (P == Precision::Fast)
+        return pNormCDF((x - mu) / sdev);
+    else if constexpr (P == Precision::Standard)
+        return pNorm(x, mu, sdev);
+    else
+    {
+        double z = (x - mu) / sdev;
+
+        if (!isfinite(z))
+            return pNorm(x, mu, sdev);
+
+        // Rounding -z / sqrt(2) to t costs up to z^2 ulps far in the lower tail. d = -z / sqrt(2) - t
+        // (1 / sqrt(2) in two parts) and the first order term of erfc put it back.
+        constexpr double sqrt1_2_lo = -4.833646656726457e-17;
+        double t = -z * M_SQRT1_2;
+        double d = fma(-z, M_SQRT1_2, -t) - z * sqrt1_2_lo;
+
+        return _erfc(t) / 2. - d * exp(-t * t) * (M_2_SQRTPI / 2.);
+    }
+}
+
+template<Precision P> double dNorm(const double x, const double mu = 0., const double sigma = 1.)
+{
+    if constexpr (P == Precision::Fast || P == Precision::Table)
+    {
+        // sigma must be finite and positive.
+        double z = (x - mu) / sigma;
+        return M_1_SQRT_2PI * exp(-0.5 * z * z) / sigma;
+    }
+    else if constexpr (P == Precision::Standard)
+        return dNorm(x, mu, sigma);
+    else
+    {
+        double z = fabs((x - mu) / sigma);
+
+        if (!isfinite(z) || !(sigma > 0.) || !isfinite(sigma))
+            return dNorm(x, mu, sigma);
+
+        // z^2 = z1^2 + (2 z1 + z2) z2 with z1 on a 2^-16 grid, so z1^2 is exact (as R's dnorm).
+        double z1 = ldexp(nearbyint(ldexp(z, 16)), -16), z2 = z - z1;
+        return M_1_SQRT_2PI / sigma * (exp(-0.5 * z1 * z1) * exp((-0.5 * z2 - z1) * z2));
+    }
+}
+
+template<Precision P> double qNorm(const double p, const double mu = 0., const double sdev = 1.)
+{
+    if constexpr (P != Precision::Exact)
+        return qNorm(p, mu, sdev);
+    else
+    {
+        double z = _erf(p);
+
+        // One Halley step on pNorm(z) = p, cubic from Acklam's 1e-9. For p in [1/4, 3/4] the residual
+        // comes from erf and p - 1/2 (exact there), where pNorm(z) - p would cancel.
+        if (p >= DBL_MIN && p < 1.)
+        {
+            double e;
+
+            if (p >= 0.25 && p <= 0.75)
+                e = _erfSmall(z * M_SQRT1_2) / 2. - (p - 0.5);
+            else if (z < 0.)
+                e = pNorm<Precision::Exact>(z) - p;
+            else
+                e = (1. - p) - pNorm<Precision::Exact>(-z);
+
+            double u = e / dNorm<Precision::Exact>(z);
+            z -= u / (1. + z * u / 2.);
+        }
+
+        return mu + (z * sdev);
+    }
+}
+
+// Table tier: quintic Hermite interpolation (value, first and second derivative at both ends of each
+// interval) in tables built on first use, for latency bound callers. No exp, log or sign branch per call.
+//   pNorm: Phi(-|z|) for |z| < 8.5 in steps of 1/32, 13 KB. Beyond 8.5 the result is 0 or 1 (Phi(-8.5)
+//          is 9.5e-18). Interpolation error is below h^6 / 46080 max|phi^(5)| = 5e-14, absolute.
+//   qNorm: z(p) for min(p, 1 - p) in [2^-64, 1/2], 2^NORMAL_TABLE_BITS intervals per binade indexed by
+//          the exponent and leading mantissa bits of p (a log spaced grid without a log), 48 KB. Largest
+//          error 8e-11 relative on a dense scan, 3e-12 below p = 2^-30. Smaller p use the Exact tier.
+constexpr double NORMAL_TABLE_ZMAX = 8.5;
+constexpr int NORMAL_TABLE_ZSTEPS = 32;
+constexpr int NORMAL_TABLE_BITS = 4;
+constexpr int NORMAL_TABLE_BINADES = 64;
+
+class NormalTable
+{
+public:
+    NormalTable()
+    {
+        // Phi(-u): f' = -phi(u), f'' = u phi(u).
+        const double h = 1. / NORMAL_TABLE_ZSTEPS;
+        size_t n = size_t(NORMAL_TABLE_ZMAX * NORMAL_TABLE_ZSTEPS);
+        auto pAt = [](const double u, double f[3])
+        {
+            double d = dNorm<Precision::Exact>(u);
+            f[0] = pNorm<Precision::Exact>(-u);
+            f[1] = -d;
+            f[2] = u * d;
+        };
+
+        pc.resize(6 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            double f0[3], f1[3];
+            pAt(i * h, f0);
+            pAt((i + 1) * h, f1);
+            hermite(f0, f1, h, &pc[6 * i]);
+        }
+
+        // z(p): z' = 1 / phi(z), z'' = z z'^2. The last interval starts at 1/2, for p = 1/2 itself.
+        const int steps = 1 << NORMAL_TABLE_BITS;
+        auto qAt = [](const double p, double f[3])
+        {
+            f[0] = qNorm<Precision::Exact>(p);
+            f[1] = 1. / dNorm<Precision::Exact>(f[0]);
+            f[2] = f[0] * f[1] * f[1];
+        };
+
+        n = size_t(NORMAL_TABLE_BINADES - 1) * steps + 1;
+        qc.resize(6 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            double f0[3], f1[3], binade = ldexp(1., int(i / steps) - NORMAL_TABLE_BINADES);
+            double p0 = binade * (1. + double(i % steps) / steps), hp = binade / steps;
+            qAt(p0, f0);
+            qAt(p0 + hp, f1);
+            hermite(f0, f1, hp, &qc[6 * i]);
+        }
+    }
+
+    double p(const double z) const
+    {
+        double u = fabs(z) * NORMAL_TABLE_ZSTEPS;
+
+        if (!(u < NORMAL_TABLE_ZMAX * NORMAL_TABLE_ZSTEPS))
+            return isnan(z) ? z : (z < 0.) ? 0. : 1.;
+
+        int i = int(u);
+        double lower = horner(&pc[6 * i], u - i);
+
+        // lower or 1 - lower without a branch on the sign of z.
+        return fabs(double(z >= 0.) - lower);
+    }
+
+    // z(p), or NAN when min(p, 1 - p) is below the table.
+    double q(const double p) const
+    {
+        // Lower tail, and the sign of p - 1/2 for the result (z <= 0 here). 1 - p is exact for p in [1/2, 1].
+        double r = fmin(p, 1. - p);
+
+        if (!(r >= 0x1p-64))
+            return NAN;
+
+        constexpr int shift = 52 - NORMAL_TABLE_BITS;
+        constexpr uint64_t first = uint64_t(1023 - NORMAL_TABLE_BINADES) << NORMAL_TABLE_BITS;
+        uint64_t bits = std::bit_cast<uint64_t>(r);
+        double t = double(int64_t(bits & ((uint64_t(1) << shift) - 1))) * 0x1p-48;
+        double z = horner(&qc[6 * size_t((bits >> shift) - first)], t);
+
+        return copysign(z, p - 0.5);
+    }
+
+private:
+    std::vector<double> pc, qc; // 6 coefficients in t in [0, 1) per interval
+
+    // Quintic in t = (x - x0) / h matching f, f', f'' at x0 (f0) and x0 + h (f1).
+    static void hermite(const double f0[3], const double f1[3], const double h, double* c)
+    {
+        long double a0 = f0[0], a1 = (long double)f0[1] * h, a2 = (long double)f0[2] * h * h / 2;
+        long double A = f1[0] - (a0 + a1 + a2), B = (long double)f1[1] * h - (a1 + 2 * a2), C = (long double)f1[2] * h * h - 2 * a2;
+
+        c[0] = double(a0);
+        c[1] = double(a1);
+        c[2] = double(a2);
+        c[3] = double(10 * A - 4 * B + C / 2);
+        c[4] = double(-15 * A + 7 * B - C);
+        c[5] = double(6 * A - 3 * B + C / 2);
+    }
+
+    static double horner(const double* c, const double t)
+    {
+        return c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5]))));
+    }
+};
+
+// Built on first use, thread safe.
+static const NormalTable& normalTable()
+{
+    static const NormalTable table;
+    return table;
+}
+
+template<> double pNorm<Precision::Table>(const double x, const double mu, const double sdev)
+{
+    return normalTable().p((x - mu) / sdev);
+}
+
+template<> double qNorm<Precision::Table>(const double p, const double mu, const double sdev)
+{
+    double z = normalTable().q(p);
+
+    return isnan(z) ? qNorm<Precision::Exact>(p, mu, sdev) : mu + (z * sdev);
+}
+
 #endif
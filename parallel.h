@@ -0,0 +1,261 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+  Thread pool and chunked parallel reduction
+  Large inputs are cut into cache-sized chunks, each chunk is reduced by whichever pool thread
+  picks it up, and the partial results are combined in chunk order. Chunk boundaries depend only
+  on n, so a result is the same for any number of threads. Inputs shorter than the parallel
+  threshold are reduced as a single chunk on the calling thread.
+  Usage:
+     threadPool().run(count, fn)            calls fn(i) for i in [0, count), returns when all are done
+     parallelReduce<R>(n, chunk, combine)   chunk(begin, end) -> R, combine(R, R) -> R
+     parallelFor(n, fn)                     fn(begin, end) over chunks of [0, n), for element-wise work
+     parallelSort(first, last, comp)        std::sort, slices sorted and merged on the pool
+     setParallelThreshold(n)                smallest input reduced in parallel
+*/
+
+// Elements per chunk (128 KB of doubles, sized to stay in L2).
+constexpr size_t PARALLEL_CHUNK = 1u << 14;
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(const unsigned threads = std::thread::hardware_concurrency())
+    {
+        // The calling thread also works, so one less worker than threads.
+        for (unsigned i = 1; i < std::max(1u, threads); i++)
+            workers.emplace_back([this]() { work(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(workers.size()) + 1; }
+
+    // Call fn(i) for every i in [0, count) and wait for all of them. Calls made from inside
+    // a pool task, on a worker or on the calling thread, run serially on that thread rather
+    // than waiting on the busy pool. If fn throws, the tasks not yet started are skipped and
+    // the first exception is rethrown here once no thread is still running fn.
+    void run(const size_t count, const std::function<void(size_t)>& fn)
+    {
+        if (workers.empty() || count < 2 || isWorker())
+        {
+            for (size_t i = 0; i < count; i++)
+                fn(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> one_job(running);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            job = &fn;
+            jobCount = count;
+            next = 0;
+            done = 0;
+            failed = false;
+            generation++;
+        }
+        wake.notify_all();
+
+        {
+            // The calling thread runs tasks too; nested calls from them must not wait on running.
+            struct CallerScope
+            {
+                CallerScope() { isWorker() = true; }
+                ~CallerScope() { isWorker() = false; }
+            } scope;
+
+            drain();
+        }
+
+        std::unique_lock<std::mutex> lock(m);
+        finished.wait(lock, [this]() { return done == jobCount && busy == 0; });
+        job = nullptr;
+
+        std::exception_ptr e = error;
+        error = nullptr;
+        lock.unlock();
+        if (e)
+            std::rethrow_exception(e);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex m, running;
+    std::condition_variable wake, finished;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> next{ 0 }, done{ 0 };
+    std::atomic<bool> failed{ false };
+    std::exception_ptr error;
+    unsigned busy = 0;
+    unsigned long long generation = 0;
+    bool stop = false;
+
+    // True on the workers, and on the calling thread of run() while it works on the job.
+    static bool& isWorker()
+    {
+        thread_local bool worker = false;
+        return worker;
+    }
+
+    void drain()
+    {
+        for (;;)
+        {
+            size_t i = next.fetch_add(1);
+            if (i >= jobCount)
+                break;
+
+            // A task that throws must not end a worker thread; the exception goes back to run().
+            if (!failed)
+            {
+                try
+                {
+                    (*job)(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    if (!failed.exchange(true))
+                        error = std::current_exception();
+                }
+            }
+
+            if (done.fetch_add(1) + 1 == jobCount)
+            {
+                std::lock_guard<std::mutex> lock(m);
+                finished.notify_all();
+            }
+        }
+    }
+
+    void work()
+    {
+        unsigned long long seen = 0;
+
+        isWorker() = true;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [&]() { return stop || (generation != seen && job != nullptr); });
+                if (stop)
+                    return;
+                seen = generation;
+                busy++;
+            }
+
+            drain();
+
+            {
+                std::lock_guard<std::mutex> lock(m);
+                busy--;
+            }
+            finished.notify_all();
+        }
+    }
+};
+
+// Shared pool, one thread per hardware thread.
+ThreadPool& threadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+static size_t& parallelThresholdValue()
+{
+    static size_t threshold = 1u << 18;
+    return threshold;
+}
+
+size_t parallelThreshold() { return parallelThresholdValue(); }
+
+// Inputs with fewer elements than this take the serial path.
+void setParallelThreshold(const size_t n) { parallelThresholdValue() = n; }
+
+// Reduce [0, n): chunk(begin, end) gives the partial result of a range, combine(a, b) joins
+// two adjacent partial results (a before b).
+template<typename R, typename ChunkFn, typename CombineFn>
+R parallelReduce(const size_t n, ChunkFn chunk, CombineFn combine)
+{
+    if (n < parallelThreshold() || n <= PARALLEL_CHUNK)
+        return chunk(size_t(0), n);
+
+    size_t chunks = (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+    std::vector<R> partial(chunks);
+
+    threadPool().run(chunks, [&](size_t c) { partial[c] = chunk(c * PARALLEL_CHUNK, std::min(n, (c + 1) * PARALLEL_CHUNK)); });
+
+    R r = partial[0];
+    for (size_t c = 1; c < chunks; c++)
+        r = combine(r, partial[c]);
+
+    return r;
+}
+
+// Call fn(begin, end) for the chunks of [0, n) (element-wise work, nothing to combine).
+template<typename Fn>
+void parallelFor(const size_t n, Fn fn)
+{
+    if (n < parallelThreshold() || n <= PARALLEL_CHUNK)
+    {
+        fn(size_t(0), n);
+        return;
+    }
+
+    size_t chunks = (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+    threadPool().run(chunks, [&](size_t c) { fn(c * PARALLEL_CHUNK, std::min(n, (c + 1) * PARALLEL_CHUNK)); });
+}
+
+// Sort [first, last): up to 64 slices are sorted in parallel, then adjacent runs are merged in
+// parallel rounds (log2(slices) rounds).
+template<typename It, typename Compare>
+void parallelSort(It first, It last, Compare comp)
+{
+    size_t n = size_t(last - first);
+
+    if (n < parallelThreshold() || n <= PARALLEL_CHUNK)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    size_t slices = std::min<size_t>(64, (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK);
+    auto at = [&](size_t s) { return first + n * s / slices; };
+
+    threadPool().run(slices, [&](size_t s) { std::sort(at(s), at(s + 1), comp); });
+
+    for (size_t width = 1; width < slices; width *= 2)
+    {
+        threadPool().run((slices + 2 * width - 1) / (2 * width), [&](size_t m)
+        {
+            size_t lo = 2 * m * width, mid = std::min(slices, lo + width), hi = std::min(slices, lo + 2 * width);
+            std::inplace_merge(at(lo), at(mid), at(hi), comp);
+        });
+    }
+}
+
+#endif
@@ -30,6 +30,15 @@ double dPois(double x, double lambda)
 
     x = round(x);
 
+    // Small terms: x log(lambda) - lambda - log(x!) with the shared log factorial table.
+    if (x <= LOG_FACTORIAL_DIRECT_N && lambda > 0.)
+    {
+        double lx = x * log(lambda), lf = logFactorial(unsigned(x));
+
+        if (fabs(lx) + lambda + lf <= LOG_FACTORIAL_DIRECT)
+            return exp(lx - lambda - lf);
+    }
+
     return dpois_raw(x, lambda);
 }
 
@@ -139,17 +148,52 @@ double pPois(double x, double lambda)
     return pgamma(lambda, x + 1, 1., lower_tail);
 }
 
-// The quantile function of the Poisson distribution.
+// Step y by incr until F(y - incr) < p <= F(y), z = F(y). Unit steps update F by the pmf recurrence
+// f(y + 1) = f(y) lambda / (y + 1) instead of a fresh pgamma evaluation for every step.
 static double doPoisSearch(double y, double* z, double p, double lambda, double incr)
 {
+    double f;
+
+    if (incr == 1. && (f = dPois(y, lambda)) > 0.)
+    {
+        if (*z >= p)
+        {
+            // Search to left, F(y - 1) = F(y) - f(y). The difference cancels as F falls into a deep
+            // lower tail, so F is evaluated afresh each time it drops by a factor 100.
+            for (double zref = *z;;)
+            {
+                double newz = *z - f;
+
+                if (y > 0 && newz < 0.01 * zref)
+                    zref = newz = pPois(y - 1, lambda);
+                if (y == 0 || newz < p)
+                    return y;
+                f *= y / lambda;
+                y--;
+                *z = newz;
+            }
+        }
+
+        // Search to right, until the terms underflow (then with pPois below).
+        while ((f *= lambda / (y + 1)) > 0.)
+        {
+            y++;
+            if ((*z += f) >= p)
+                return y;
+        }
+    }
+
     if (*z >= p)
     {
         // search to left 
         for (;;)
         {
-            if (y == 0 || (*z = pPois(y - incr, lambda)) < p)
+            double newz;
+
+            if (y == 0 || (newz = pPois(y - incr, lambda)) < p)
                 return y;
             y = fmax2(0, y - incr);
+            *z = newz;
         }
     }
     else
@@ -164,55 +208,116 @@ static double doPoisSearch(double y, double* z, double p, double lambda, double
     }
 }
 
-double qPois(double p, double lambda)
+// Cornish-Fisher start for the search.
+static double poisStart(const double p, const double lambda)
+{
+    double mu = lambda;
+    double sigma = sqrt(lambda);
+    double gamma = 1.0 / sigma;
+    double z = qNorm(p, 0., 1.);
+
+    return fmax2(0, round(mu + sigma * (z + gamma * (z * z - 1) / 6)));
+}
+
+// Search from y, z = F(y): unit steps for small lambda, otherwise steps shrinking by 100 from y / 1000.
+static double poisSearch(double y, double* z, double p, double lambda)
 {
-    double mu, sigma, gamma, z, y;
+    if (lambda < 1e5)
+        return doPoisSearch(y, z, p, lambda, 1);
+
+    double incr = floor(y * 0.001), oldincr;
 
+    do
+    {
+        oldincr = incr;
+        y = doPoisSearch(y, z, p, lambda, incr);
+        incr = fmax2(1, floor(incr / 100));
+    } while (oldincr > 1 && incr > lambda * 1e-15);
+
+    return y;
+}
+
+// Arguments the search cannot take, with the quantile to return for them (NAN when invalid).
+static bool poisSpecial(const double p, const double lambda, double* y)
+{
 #ifdef IEEE_754
     if (isnan(p) || isnan(lambda))
-        return p + lambda;
+    {
+        *y = p + lambda;
+        return true;
+    }
 #endif
 
+    *y = NAN;
     if (!isfinite(lambda))
-        return NAN;
+        return true;
 
     if (lambda < 0)
-        return NAN;
+        return true;
 
+    *y = 0;
     if (lambda == 0)
-        return 0;
+        return true;
 
+    *y = NAN;
     if (p < 0 || p > 1)
-        return NAN;
+        return true;
+
+    *y = 0;
     if (p == 0)
-        return 0;
-    if (p == 1)
-        return ML_POSINF;
+        return true;
 
-    mu = lambda;
-    sigma = sqrt(lambda);
-    gamma = 1.0 / sigma;
+    *y = ML_POSINF;
+    return (p == 1 || p + 1.01 * DBL_EPSILON >= 1.);
+}
 
-    if (p + 1.01 * DBL_EPSILON >= 1.)
-        return ML_POSINF;
+// The quantile function of the Poisson distribution.
+double qPois(double p, double lambda)
+{
+    double y, z;
+
+    if (poisSpecial(p, lambda, &y))
+        return y;
 
-    z = qNorm(p, 0., 1.);
-    y = round(mu + sigma * (z + gamma * (z * z - 1) / 6));
+    y = poisStart(p, lambda);
     z = pPois(y, lambda);
 
     p *= 1 - 64 * DBL_EPSILON;
 
-    if (lambda < 1e5)
-        return doPoisSearch(y, &z, p, lambda, 1);
+    return poisSearch(y, &z, p, lambda);
+}
 
-    double incr = floor(y * 0.001), oldincr;
+// Quantiles of a vector of probabilities in one sweep. They are answered in increasing order of p,
+// each search continuing from the previous quantile with the incremental CDF; a start more than 64
+// above it begins a fresh search.
+std::vector<double> qPois(const std::vector<double>& p, const double lambda)
+{
+    std::vector<double> y(p.size());
+    std::vector<size_t> order;
 
-    do
+    for (size_t i = 0; i < p.size(); i++)
+        if (!poisSpecial(p[i], lambda, &y[i]))
+            order.push_back(i);
+
+    std::sort(order.begin(), order.end(), [&p](const size_t a, const size_t b) { return p[a] < p[b]; });
+
+    double yc = -1., zc = 0.;
+    for (size_t i : order)
     {
-        oldincr = incr;
-        y = doPoisSearch(y, &z, p, lambda, incr);
-        incr = fmax2(1, floor(incr / 100));
-    } while (oldincr > 1 && incr > lambda * 1e-15);
+        double pi = p[i] * (1 - 64 * DBL_EPSILON);
+        double start = poisStart(p[i], lambda);
+
+        if (yc < 0. || start - yc > 64.)
+        {
+            yc = start;
+            zc = pPois(yc, lambda);
+            yc = poisSearch(yc, &zc, pi, lambda);
+        }
+        else
+            yc = doPoisSearch(yc, &zc, pi, lambda, 1);
+
+        y[i] = yc;
+    }
 
     return y;
 }
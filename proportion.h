@@ -0,0 +1,148 @@
+#ifndef PROPORTION_H
+#define PROPORTION_H
+
+#include <span>
+#include "common.h"
+#include "normal.h"
+#include "binomial.h"
+
+/*
+  Exact binomial tests and confidence intervals for proportions
+  One experiment is x successes in n trials; a batch is given as two arrays (successes, trials),
+  and its experiments are spread over the thread pool in blocks.
+     binomTest is binom.test: the p-value sums the binomial probabilities of outcomes no more
+       likely than x (two-sided, R's relative tolerance 1e-7), or one tail. The outcomes on the far
+       side of n p0 are found by bisection, since the probabilities fall monotonically there.
+     Clopper-Pearson is the exact interval of binom.test, beta quantiles qbeta(alpha / 2, x, n - x + 1)
+       and qbeta(1 - alpha / 2, x + 1, n - x).
+     Wilson is the score interval of prop.test(correct = FALSE), Agresti-Coull the Wald interval
+       of x + z^2 / 2 successes in n + z^2 trials, clipped to [0, 1].
+  Usage:
+     binomTest(x, n, p0 = 0.5, alternative = Alternative::TwoSided)
+     binomTest(successes, trials, pValue, p0 = 0.5, alternative = Alternative::TwoSided)
+     proportionCI(x, n, conf = 0.95, method = ProportionInterval::ClopperPearson)   std::pair(lower, upper)
+     proportionCI(successes, trials, lower, upper, conf = 0.95, method = ProportionInterval::ClopperPearson)
+*/
+
+enum class Alternative { TwoSided, Less, Greater };
+enum class ProportionInterval { ClopperPearson, Wilson, AgrestiCoull };
+
+// Experiments per task of a batch.
+constexpr size_t PROPORTION_BLOCK = 256;
+
+// p-value of the exact test of H0: p = p0 for x successes in n trials, binom.test(x, n, p0).
+double binomTest(const unsigned x, const unsigned n, const double p0 = 0.5, const Alternative alternative = Alternative::TwoSided)
+{
+    if (x > n || !(p0 >= 0. && p0 <= 1.))
+        return NAN;
+
+    if (alternative == Alternative::Less)
+        return pBinom(x, n, p0);
+    if (alternative == Alternative::Greater)
+        return (x == 0) ? 1. : pBinom(x - 1, n, p0, false);
+
+    double m = n * p0;
+
+    if (p0 == 0. || p0 == 1.)
+        return (x == m) ? 1. : 0.;
+    if (x == m)
+        return 1.;
+
+    // Outcomes on the other side of m with log density at most that of x (plus the tolerance).
+    const double q0 = 1. - p0, d = binomLogPmf(x, n, p0, q0) + log1p(1e-7);
+    auto atMost = [&](const double k) { return binomLogPmf(k, n, p0, q0) <= d; };
+
+    if (x < m)
+    {
+        // The first k >= ceil(m) with f(k) <= f(x); P(X >= k) is added.
+        double lo = ceil(m), hi = n;
+
+        if (!atMost(hi))
+            return pBinom(x, n, p0);
+        while (hi - lo > 0.)
+        {
+            double mid = floor((lo + hi) / 2.);
+            if (atMost(mid))
+                hi = mid;
+            else
+                lo = mid + 1.;
+        }
+
+        return fmin2(1., pBinom(x, n, p0) + pBinom(unsigned(hi) - 1, n, p0, false));
+    }
+
+    // The last k <= floor(m) with f(k) <= f(x); P(X <= k) is added.
+    double lo = 0., hi = floor(m);
+
+    if (!atMost(lo))
+        return pBinom(x - 1, n, p0, false);
+    while (hi - lo > 0.)
+    {
+        double mid = ceil((lo + hi) / 2.);
+        if (atMost(mid))
+            lo = mid;
+        else
+            hi = mid - 1.;
+    }
+
+    return fmin2(1., pBinom(unsigned(lo), n, p0) + pBinom(x - 1, n, p0, false));
+}
+
+// Confidence interval for the proportion x / n at level conf, returns std::pair(lower, upper).
+std::pair<double, double> proportionCI(const unsigned x, const unsigned n, const double conf = 0.95, const ProportionInterval method = ProportionInterval::ClopperPearson)
+{
+    if (n == 0 || x > n || !(conf > 0. && conf < 1.))
+        return std::make_pair(NAN, NAN);
+
+    double alpha = 1. - conf;
+
+    if (method == ProportionInterval::ClopperPearson)
+    {
+        double lower = (x == 0) ? 0. : qBeta(alpha / 2., x, n - x + 1.);
+        double upper = (x == n) ? 1. : qBeta(alpha / 2., x + 1., n - x, false);
+
+        return std::make_pair(lower, upper);
+    }
+
+    double z = qNorm(1. - alpha / 2., 0., 1.), z2 = z * z;
+
+    if (method == ProportionInterval::Wilson)
+    {
+        double phat = double(x) / n, denom = 1. + z2 / n;
+        double center = (phat + z2 / (2. * n)) / denom;
+        double half = z * sqrt(phat * (1. - phat) / n + z2 / (4. * n * n)) / denom;
+
+        return std::make_pair(fmax2(0., center - half), fmin2(1., center + half));
+    }
+
+    double nt = n + z2, pt = (x + z2 / 2.) / nt, half = z * sqrt(pt * (1. - pt) / nt);
+
+    return std::make_pair(fmax2(0., pt - half), fmin2(1., pt + half));
+}
+
+// Batch forms over experiment i = 0 ... successes.size() - 1. The outputs must hold as many values.
+void binomTest(std::span<const unsigned> successes, std::span<const unsigned> trials, std::span<double> pValue, const double p0 = 0.5, const Alternative alternative = Alternative::TwoSided)
+{
+    size_t m = successes.size();
+
+    assert(trials.size() == m && pValue.size() >= m);
+    threadPool().run((m + PROPORTION_BLOCK - 1) / PROPORTION_BLOCK, [&](size_t b)
+    {
+        for (size_t i = b * PROPORTION_BLOCK; i < std::min(m, (b + 1) * PROPORTION_BLOCK); i++)
+            pValue[i] = binomTest(successes[i], trials[i], p0, alternative);
+    });
+}
+
+void proportionCI(std::span<const unsigned> successes, std::span<const unsigned> trials, std::span<double> lower, std::span<double> upper, const double conf = 0.95, const ProportionInterval method = ProportionInterval::ClopperPearson)
+{
+    size_t m = successes.size();
+
+    assert(trials.size() == m && lower.size() >= m && upper.size() >= m);
+    threadPool().run((m + PROPORTION_BLOCK - 1) / PROPORTION_BLOCK, [&](size_t b)
+    {
+        for (size_t i = b * PROPORTION_BLOCK; i < std::min(m, (b + 1) * PROPORTION_BLOCK); i++)
+            std::tie(lower[i], upper[i]) = proportionCI(successes[i], trials[i], conf, method);
+    });
+}
+
+#endif
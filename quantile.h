@@ -0,0 +1,180 @@
+#ifndef QUANTILE_H
+#define QUANTILE_H
+
+#include "common.h"
+
+/*
+  Sample Quantiles
+  Quantiles corresponding to the given probabilities, computed with a single multi-select 
+  over one scratch copy of the data (the copy is reordered, the input is left untouched). 
+  The order statistics needed by every requested probability are located together, so 
+  asking for p50, p90, p99 and p99.9 costs little more than one median.
+  Usage:
+     quantile(x, probs, type = 7)
+  Arguments:
+     x = data (vector, span, or any forward range)
+     probs = probabilities in [0, 1]
+     type = one of the nine quantile algorithms of Hyndman & Fan (1996), as in R:
+       1 inverse of empirical CDF, 2 as 1 with averaging at discontinuities, 3 nearest even order statistic,
+       4 linear interpolation of empirical CDF, 5 piecewise linear with knots at midpoints,
+       6 p[k] = k / (n + 1), 7 p[k] = (k - 1) / (n - 1) (R default), 8 median-unbiased, 9 normal-unbiased
+*/
+
+// Segments longer than this are split between two threads by the multi-select.
+constexpr size_t QUANTILE_PARALLEL_MIN = 1u << 20;
+
+// Place the order statistics at the sorted (0-based) positions [kfirst, klast) in [first, last).
+//   Positions are relative to the start of the whole buffer, offset is that of first.
+template<typename It, typename KIt>
+void multiSelect(It first, It last, size_t offset, KIt kfirst, KIt klast)
+{
+    if (kfirst == klast || last - first < 2)
+        return;
+
+    KIt kmid = kfirst + (klast - kfirst) / 2;
+    It nth = first + (*kmid - offset);
+
+    std::nth_element(first, nth, last);
+
+    // Everything left of nth is <= *nth, everything right is >=, so each side is independent.
+    multiSelect(first, nth, offset, kfirst, kmid);
+    multiSelect(nth + 1, last, offset + size_t(nth - first) + 1, kmid + 1, klast);
+}
+
+// multiSelect on the thread pool. Rounds of partitions, all segments of a round at once, split every
+// segment longer than QUANTILE_PARALLEL_MIN at its middle order statistic until there is a segment
+// per thread; the segments are then finished independently.
+template<typename It, typename KIt>
+void parallelMultiSelect(It first, It last, KIt kfirst, KIt klast)
+{
+    struct Segment
+    {
+        It first, last;
+        size_t offset;
+        KIt kfirst, klast;
+    };
+    std::vector<Segment> segments{ { first, last, 0, kfirst, klast } };
+    std::atomic<bool> split{ true };
+
+    while (split && segments.size() < threadPool().size())
+    {
+        std::vector<Segment> halves(2 * segments.size(), Segment{ first, first, 0, kfirst, kfirst });
+
+        split = false;
+        threadPool().run(segments.size(), [&](size_t i)
+        {
+            Segment g = segments[i];
+
+            if (g.kfirst == g.klast || size_t(g.last - g.first) <= QUANTILE_PARALLEL_MIN)
+            {
+                halves[2 * i] = g;
+                return;
+            }
+
+            KIt kmid = g.kfirst + (g.klast - g.kfirst) / 2;
+            It nth = g.first + (*kmid - g.offset);
+
+            std::nth_element(g.first, nth, g.last);
+            halves[2 * i] = Segment{ g.first, nth, g.offset, g.kfirst, kmid };
+            halves[2 * i + 1] = Segment{ nth + 1, g.last, g.offset + size_t(nth - g.first) + 1, kmid + 1, g.klast };
+            split = true;
+        });
+
+        segments.clear();
+        for (const Segment& g : halves)
+            if (g.kfirst != g.klast && g.last - g.first >= 2)
+                segments.push_back(g);
+    }
+
+    threadPool().run(segments.size(), [&](size_t i)
+    {
+        multiSelect(segments[i].first, segments[i].last, segments[i].offset, segments[i].kfirst, segments[i].klast);
+    });
+}
+
+// Order statistics (0-based, lo and hi) and interpolation weight of probability p for the given type.
+static void quantilePosition(const double p, const size_t n, const unsigned type, size_t& lo, size_t& hi, double& gamma)
+{
+    constexpr double fuzz = 4 * DBL_EPSILON;
+    double m;
+
+    switch (type)
+    {
+    case 1: case 2: case 4: m = 0.; break;
+    case 3: m = -0.5; break;
+    case 5: m = 0.5; break;
+    case 6: m = p; break;
+    case 8: m = (p + 1.) / 3.; break;
+    case 9: m = p / 4. + 3. / 8.; break;
+    default: m = 1. - p; break;
+    }
+
+    double np = n * p + m;
+    double j = floor(np + fuzz);
+    double g = np - j;
+
+    if (type == 1)
+        gamma = (g > fuzz) ? 1. : 0.;
+    else if (type == 2)
+        gamma = (g > fuzz) ? 1. : 0.5;
+    else if (type == 3)
+        gamma = (fabs(g) <= fuzz && fmod(j, 2.) == 0.) ? 0. : 1.;
+    else
+        gamma = (fabs(g) <= fuzz) ? 0. : g;
+
+    // x[j] and x[j + 1] (1-based), clamped to the sample.
+    lo = size_t(fmin2(fmax2(j, 1.), double(n))) - 1;
+    hi = size_t(fmin2(fmax2(j + 1., 1.), double(n))) - 1;
+}
+
+template<typename It>
+std::vector<double> quantiles(It first, It last, const std::vector<double>& probs, const unsigned type = 7)
+{
+    std::vector<double> q(probs.size(), NAN);
+    std::vector<IterValue<It>> x(first, last);
+    const size_t n = x.size();
+
+    if (n == 0)
+        return q;
+
+    std::vector<size_t> lo(probs.size()), hi(probs.size()), k;
+    std::vector<double> gamma(probs.size());
+
+    for (size_t i = 0; i < probs.size(); i++)
+    {
+        if (isnan(probs[i]) || probs[i] < 0. || probs[i] > 1.)
+            continue;
+        quantilePosition(probs[i], n, type, lo[i], hi[i], gamma[i]);
+        k.push_back(lo[i]);
+        k.push_back(hi[i]);
+    }
+
+    std::sort(k.begin(), k.end());
+    k.erase(std::unique(k.begin(), k.end()), k.end());
+
+    parallelMultiSelect(x.begin(), x.end(), k.begin(), k.end());
+
+    for (size_t i = 0; i < probs.size(); i++)
+    {
+        if (isnan(probs[i]) || probs[i] < 0. || probs[i] > 1.)
+            continue;
+        q[i] = (gamma[i] == 0.) ? double(x[lo[i]]) : (1. - gamma[i]) * double(x[lo[i]]) + gamma[i] * double(x[hi[i]]);
+    }
+
+    return q;
+}
+
+template<std::ranges::forward_range R>
+std::vector<double> quantiles(const R& r, const std::vector<double>& probs, const unsigned type = 7)
+{
+    return quantiles(std::ranges::begin(r), std::ranges::end(r), probs, type);
+}
+
+// Single quantile.
+template<std::ranges::forward_range R>
+double quantile(const R& r, const double p, const unsigned type = 7)
+{
+    return quantiles(r, { p }, type)[0];
+}
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include "common.h"
+#include "student.h"
+
+/*
+  Multiple linear regression (ordinary least squares)
+  Fits y = b0 + b1 x1 + ... + bp xp from the predictor columns without building the design matrix.
+  Only the means and the centered (p + 1) x (p + 1) cross product matrix of x1..xp, y are kept,
+  so memory is O(p^2) for any n. Rows are reduced in blocks that stay in cache: each block is
+  centered on its own means, its cross products come from the SIMD dot product kernel, and the
+  blocks are merged like RunningStats (Chan et al.). Large inputs are split over the thread pool
+  in slices that depend only on n, so results do not change with the number of threads.
+  The normal equations are scaled to unit diagonal and solved by Cholesky; a predictor that is
+  (numerically) a linear combination of the others gives NAN coefficients.
+  Usage:
+     RegressionFit fit = regress({ x1, x2, ... }, y);           like summary(lm(y ~ x1 + x2 + ...))
+     fit.coefficients[j], fit.standardErrors[j], fit.tValues[j], fit.pValues[j]   (j = 0 is the intercept)
+     fit.confidenceInterval(j, 0.95)
+     LinearModel m(p);  m.push(row, y);  m.merge(other);  m.fit();   streaming or sharded data
+*/
+
+// Rows per cache block: the centered block of p + 1 columns is reused for every column pair.
+constexpr size_t REGRESSION_BLOCK = 256;
+
+// Coefficients and tests of a fitted model. Index 0 is the intercept, j the j-th predictor.
+struct RegressionFit
+{
+    std::vector<double> coefficients;
+    std::vector<double> standardErrors;
+    std::vector<double> tValues;
+    std::vector<double> pValues; // 2-tailed, H0: coefficient = 0
+    double residualStandardError = NAN;
+    double rSquared = NAN;
+    double adjustedRSquared = NAN;
+    double n = 0.;
+    unsigned df = 0; // residual degrees of freedom, n - p - 1
+
+    // Confidence interval for coefficient j.
+    std::pair<double, double> confidenceInterval(const size_t j, const double level = 0.95) const
+    {
+        double t = qt(1. - (1. - level) / 2., df);
+        return std::make_pair(coefficients[j] - t * standardErrors[j], coefficients[j] + t * standardErrors[j]);
+    }
+};
+
+// Mergeable accumulator of the normal equations for p predictors.
+class LinearModel
+{
+public:
+    explicit LinearModel(const size_t predictors) : p(predictors), k(predictors + 1), mu(k, 0.), c(k * k, 0.), d(k) { }
+
+    size_t predictors() const { return p; }
+    double count() const { return n; }
+
+    // Add one observation, x holds the p predictor values.
+    void push(const double* x, const double y)
+    {
+        n++;
+        for (size_t j = 0; j < k; j++)
+        {
+            double v = (j < p) ? x[j] : y;
+            d[j] = v - mu[j];
+            mu[j] += d[j] / n;
+        }
+        // Upper triangle, sum of (v - old mean)(v - new mean).
+        for (size_t j = 0; j < k; j++)
+        {
+            double r = d[j] * (n - 1.) / n;
+            for (size_t i = j; i < k; i++)
+                c[j * k + i] += r * d[i];
+        }
+    }
+
+    void push(const std::vector<double>& x, const double y)
+    {
+        assert(x.size() == p);
+        push(x.data(), y);
+    }
+
+    // Add rows [0, m) of the columns x[0..p-1] and y (one cache block).
+    void pushBlock(const double* const* x, const double* y, const size_t m)
+    {
+        if (m == 0)
+            return;
+
+        LinearModel block(p);
+        std::vector<double>& centered = blockBuffer(k * m);
+        std::vector<double> s(k);
+
+        // Center every column on its block mean, s[j] is the rounding left in the centered sum.
+        for (size_t j = 0; j < k; j++)
+        {
+            const double* col = (j < p) ? x[j] : y;
+            double* out = centered.data() + j * m;
+            double mj = simdSum(col, m) / m;
+
+            for (size_t i = 0; i < m; i++)
+                out[i] = col[i] - mj;
+            s[j] = simdSum(out, m);
+            block.mu[j] = mj + s[j] / m;
+        }
+
+        // Cross products of the centered columns, four column pairs per pass over column j.
+        for (size_t j = 0; j < k; j++)
+        {
+            const double* cj = centered.data() + j * m;
+            for (size_t i = j; i < k; i += 4)
+            {
+                const double* y4[4];
+                double dots[4];
+
+                for (size_t q = 0; q < 4; q++)
+                    y4[q] = centered.data() + std::min(i + q, k - 1) * m;
+                simdDot4(cj, y4, m, dots);
+                for (size_t q = 0; q < 4 && i + q < k; q++)
+                    block.c[j * k + i + q] = dots[q] - s[j] * s[i + q] / m;
+            }
+        }
+        block.n = double(m);
+
+        merge(block);
+    }
+
+    // Combine the state of another accumulator over the same predictors into this one.
+    void merge(const LinearModel& other)
+    {
+        assert(other.p == p);
+
+        if (other.n == 0.)
+            return;
+
+        if (n == 0.)
+        {
+            n = other.n;
+            mu = other.mu;
+            c = other.c;
+            return;
+        }
+
+        double nab = n + other.n, w = n * other.n / nab;
+
+        for (size_t j = 0; j < k; j++)
+            d[j] = other.mu[j] - mu[j];
+        for (size_t j = 0; j < k; j++)
+            for (size_t i = j; i < k; i++)
+                c[j * k + i] += other.c[j * k + i] + d[j] * d[i] * w;
+        for (size_t j = 0; j < k; j++)
+            mu[j] += d[j] * other.n / nab;
+        n = nab;
+    }
+
+    RegressionFit fit() const
+    {
+        RegressionFit f;
+        std::vector<double> L(p * p), scale(p), g(p);
+
+        f.n = n;
+        f.df = (n > double(k)) ? unsigned(n - double(k)) : 0;
+        f.coefficients.assign(k, NAN);
+        f.standardErrors.assign(k, NAN);
+        f.tValues.assign(k, NAN);
+        f.pValues.assign(k, NAN);
+
+        // Scale Sxx to unit diagonal (a correlation matrix) before factoring, Sxx = D R D.
+        for (size_t j = 0; j < p; j++)
+        {
+            scale[j] = sqrt(c[j * k + j]);
+            if (!(scale[j] > 0.))
+                return f;
+        }
+
+        // Cholesky R = L L', L lower triangular, row major.
+        for (size_t j = 0; j < p; j++)
+        {
+            for (size_t i = j; i < p; i++)
+            {
+                double sum = c[j * k + i] / (scale[j] * scale[i]);
+                for (size_t q = 0; q < j; q++)
+                    sum -= L[i * p + q] * L[j * p + q];
+
+                if (i == j)
+                {
+                    // Pivot lost to cancellation: x_j is a combination of the earlier predictors.
+                    if (!(sum > 64 * DBL_EPSILON))
+                        return f;
+                    L[j * p + j] = sqrt(sum);
+                }
+                else
+                    L[i * p + j] = sum / L[j * p + j];
+            }
+        }
+
+        // Solve R g = D^-1 Sxy, then b = D^-1 g.
+        for (size_t j = 0; j < p; j++)
+        {
+            double sum = c[j * k + p] / scale[j];
+            for (size_t q = 0; q < j; q++)
+                sum -= L[j * p + q] * g[q];
+            g[j] = sum / L[j * p + j];
+        }
+        for (size_t j = p; j-- > 0; )
+        {
+            double sum = g[j];
+            for (size_t q = j + 1; q < p; q++)
+                sum -= L[q * p + j] * g[q];
+            g[j] = sum / L[j * p + j];
+        }
+
+        double sse = c[p * k + p], b0 = mu[p];
+        for (size_t j = 0; j < p; j++)
+        {
+            double b = g[j] / scale[j];
+            f.coefficients[j + 1] = b;
+            sse -= b * c[j * k + p];
+            b0 -= b * mu[j];
+        }
+        f.coefficients[0] = b0;
+        sse = fmax(sse, 0.);
+
+        f.rSquared = (c[p * k + p] > 0.) ? 1. - sse / c[p * k + p] : NAN;
+        if (f.df == 0)
+            return f;
+        f.adjustedRSquared = 1. - (1. - f.rSquared) * (n - 1.) / f.df;
+        f.residualStandardError = sqrt(sse / f.df);
+
+        // Var(b) = sigma^2 Sxx^-1. Diagonal from rows of L^-1 (columns of the scaled inverse),
+        // intercept from the quadratic form of the predictor means.
+        std::vector<double> inv(p * p, 0.), z(p);
+        for (size_t j = 0; j < p; j++)
+        {
+            inv[j * p + j] = 1. / L[j * p + j];
+            for (size_t i = j + 1; i < p; i++)
+            {
+                double sum = 0.;
+                for (size_t q = j; q < i; q++)
+                    sum -= L[i * p + q] * inv[q * p + j];
+                inv[i * p + j] = sum / L[i * p + i];
+            }
+        }
+
+        double sigma2 = sse / f.df, quad = 0.;
+        for (size_t j = 0; j < p; j++)
+        {
+            double diag = 0.;
+            for (size_t i = j; i < p; i++)
+                diag += inv[i * p + j] * inv[i * p + j];
+            f.standardErrors[j + 1] = sqrt(sigma2 * diag) / scale[j];
+
+            double sum = 0.;
+            for (size_t q = 0; q <= j; q++)
+                sum += inv[j * p + q] * mu[q] / scale[q];
+            quad += sum * sum;
+        }
+        f.standardErrors[0] = sqrt(sigma2 * (1. / n + quad));
+
+        for (size_t j = 0; j < k; j++)
+        {
+            f.tValues[j] = f.coefficients[j] / f.standardErrors[j];
+            f.pValues[j] = 2. * pt(-fabs(f.tValues[j]), f.df);
+        }
+
+        return f;
+    }
+
+private:
+    size_t p, k;        // predictors, variables including y
+    double n = 0.;
+    std::vector<double> mu; // means of x1..xp, y
+    std::vector<double> c;  // centered cross products, upper triangle of k x k, row major
+    std::vector<double> d;  // scratch
+
+    static std::vector<double>& blockBuffer(const size_t size)
+    {
+        thread_local std::vector<double> buffer;
+        if (buffer.size() < size)
+            buffer.resize(size);
+        return buffer;
+    }
+};
+
+// Fit y on the predictor columns x[0..p-1], all of length n.
+RegressionFit regress(const std::vector<std::vector<double>>& x, const std::vector<double>& y)
+{
+    size_t p = x.size(), n = y.size();
+    std::vector<const double*> cols(p);
+
+    for (size_t j = 0; j < p; j++)
+    {
+        assert(x[j].size() == n);
+        cols[j] = x[j].data();
+    }
+
+    // Up to 64 slices of whole blocks, each accumulated in order and merged in slice order.
+    size_t blocks = (n + REGRESSION_BLOCK - 1) / REGRESSION_BLOCK;
+    size_t slices = (n < parallelThreshold()) ? 1 : std::min<size_t>(64, (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK);
+    std::vector<LinearModel> partial(std::max<size_t>(slices, 1), LinearModel(p));
+
+    threadPool().run(slices, [&](size_t t)
+    {
+        std::vector<const double*> at(p);
+
+        for (size_t b = blocks * t / slices; b < blocks * (t + 1) / slices; b++)
+        {
+            size_t begin = b * REGRESSION_BLOCK, m = std::min(n, begin + REGRESSION_BLOCK) - begin;
+            for (size_t j = 0; j < p; j++)
+                at[j] = cols[j] + begin;
+            partial[t].pushBlock(at.data(), y.data() + begin, m);
+        }
+    });
+
+    for (size_t t = 1; t < slices; t++)
+        partial[0].merge(partial[t]);
+
+    return partial[0].fit();
+}
+
+#endif
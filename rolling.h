@@ -0,0 +1,331 @@
+#ifndef ROLLING_H
+#define ROLLING_H
+
+#include "common.h"
+
+/*
+  Rolling-window statistics
+  Statistics of the last N samples of a stream, updated as each sample arrives. Samples live in
+  a fixed ring buffer allocated once, so updates never allocate.
+     RollingStats      mean, variance, standard deviation in O(1) per sample
+     RollingQuantiles  median and quantiles in O(log N) per sample (indexable skip list)
+     RollingRegression slope, intercept and r of the last N (x, y) pairs in O(1) per pair
+  Usage:
+     RollingStats w(N);      w.push(x);  w.mean(); w.variance(); w.standardDeviation();
+     RollingQuantiles q(N);  q.push(x);  q.median(); q.quantile(p);
+     RollingRegression r(N); r.push(x, y);  r.slope(); r.intercept(); r.r(); r.fit();
+*/
+
+// Fixed-capacity ring of the most recent samples.
+template<typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(const size_t capacity) : buf(std::max<size_t>(capacity, 1)) { }
+
+    // Append x, returning true and the evicted oldest sample once the ring is full.
+    bool push(const T& x, T& evicted)
+    {
+        bool full = (n == buf.size());
+
+        if (full)
+            evicted = buf[head];
+        else
+            n++;
+        buf[head] = x;
+        head = (head + 1 == buf.size()) ? 0 : head + 1;
+
+        return full;
+    }
+
+    size_t size() const { return n; }
+    size_t capacity() const { return buf.size(); }
+    bool full() const { return n == buf.size(); }
+
+    // i-th oldest sample.
+    const T& operator[](const size_t i) const
+    {
+        size_t j = head + buf.size() - n + i;
+        return buf[(j >= buf.size()) ? j - buf.size() : j];
+    }
+
+private:
+    std::vector<T> buf;
+    size_t head = 0;
+    size_t n = 0;
+};
+
+// Mean and variance of the last N samples (add/remove Welford updates).
+class RollingStats
+{
+public:
+    explicit RollingStats(const size_t window) : ring(window) { }
+
+    void push(const double x)
+    {
+        double old;
+
+        if (!ring.push(x, old))
+        {
+            double delta = x - mu;
+            mu += delta / ring.size();
+            m2 += delta * (x - mu);
+            return;
+        }
+
+        // Replace old by x in a full window.
+        double mu_old = mu;
+        mu += (x - old) / ring.size();
+        m2 += (x - old) * (x - mu + old - mu_old);
+
+        // Rebuild from the window once per N evictions so rounding cannot accumulate (O(1) amortized).
+        if (++evictions == ring.capacity())
+            refresh();
+    }
+
+    size_t count() const { return ring.size(); }
+    double mean() const { return mu; }
+    // Sample variance (n - 1), matching variance().
+    double variance() const { return (ring.size() > 1) ? fmax2(m2, 0.) / (ring.size() - 1) : 0.; }
+    double standardDeviation() const { return sqrt(variance()); }
+
+private:
+    RingBuffer<double> ring;
+    double mu = 0.;
+    double m2 = 0.;
+    size_t evictions = 0;
+
+    void refresh()
+    {
+        RunningStats s;
+
+        for (size_t i = 0; i < ring.size(); i++)
+            s.push(ring[i]);
+
+        mu = s.mean();
+        m2 = s.variance() * (ring.size() - 1);
+        evictions = 0;
+    }
+};
+
+// Sorted multiset with O(log n) insert, erase and access by rank (Hettinger's indexable skip list).
+//   All nodes are preallocated for the capacity; node 0 is the head, links to NIL end the list.
+class IndexableSkipList
+{
+public:
+    explicit IndexableSkipList(const size_t capacity)
+    {
+        for (size_t c = capacity; c > 1; c >>= 1)
+            levels++;
+
+        size_t nodes = capacity + 1;
+        value.resize(nodes);
+        height.resize(nodes);
+        next.assign(nodes * levels, NIL);
+        width.assign(nodes * levels, 1);
+        for (size_t i = capacity; i > 0; i--)
+            freeNodes.push_back(unsigned(i));
+    }
+
+    size_t size() const { return n; }
+
+    // x must not be NAN (it has no place in the order).
+    void insert(const double x)
+    {
+        unsigned chain[64];
+        size_t steps_at[64];
+        unsigned node = 0;
+
+        for (int lvl = levels - 1; lvl >= 0; lvl--)
+        {
+            steps_at[lvl] = 0;
+            while (link(node, lvl) != NIL && value[link(node, lvl)] <= x)
+            {
+                steps_at[lvl] += span(node, lvl);
+                node = link(node, lvl);
+            }
+            chain[lvl] = node;
+        }
+
+        unsigned d = randomHeight();
+        unsigned fresh = freeNodes.back();
+        freeNodes.pop_back();
+        value[fresh] = x;
+        height[fresh] = d;
+
+        size_t steps = 0;
+        for (unsigned lvl = 0; lvl < d; lvl++)
+        {
+            unsigned prev = chain[lvl];
+            link(fresh, lvl) = link(prev, lvl);
+            link(prev, lvl) = fresh;
+            span(fresh, lvl) = span(prev, lvl) - steps;
+            span(prev, lvl) = steps + 1;
+            steps += steps_at[lvl];
+        }
+        for (unsigned lvl = d; lvl < levels; lvl++)
+            span(chain[lvl], lvl)++;
+
+        n++;
+    }
+
+    // Remove one element equal to x (which must be present).
+    void erase(const double x)
+    {
+        unsigned chain[64];
+        unsigned node = 0;
+
+        for (int lvl = levels - 1; lvl >= 0; lvl--)
+        {
+            while (link(node, lvl) != NIL && value[link(node, lvl)] < x)
+                node = link(node, lvl);
+            chain[lvl] = node;
+        }
+
+        unsigned gone = link(chain[0], 0);
+        assert(gone != NIL && value[gone] == x);
+
+        for (unsigned lvl = 0; lvl < height[gone]; lvl++)
+        {
+            unsigned prev = chain[lvl];
+            span(prev, lvl) += span(gone, lvl) - 1;
+            link(prev, lvl) = link(gone, lvl);
+        }
+        for (unsigned lvl = height[gone]; lvl < levels; lvl++)
+            span(chain[lvl], lvl)--;
+
+        freeNodes.push_back(gone);
+        n--;
+    }
+
+    // Element of 0-based rank i.
+    double operator[](size_t i) const
+    {
+        unsigned node = 0;
+
+        i++;
+        for (int lvl = levels - 1; lvl >= 0; lvl--)
+        {
+            while (link(node, lvl) != NIL && span(node, lvl) <= i)
+            {
+                i -= span(node, lvl);
+                node = link(node, lvl);
+            }
+        }
+
+        return value[node];
+    }
+
+private:
+    static constexpr unsigned NIL = ~0u;
+    unsigned levels = 1;
+    size_t n = 0;
+    std::vector<double> value;
+    std::vector<unsigned> height;
+    std::vector<unsigned> next;
+    std::vector<size_t> width;
+    std::vector<unsigned> freeNodes;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+    unsigned& link(const unsigned node, const unsigned lvl) { return next[size_t(node) * levels + lvl]; }
+    unsigned link(const unsigned node, const unsigned lvl) const { return next[size_t(node) * levels + lvl]; }
+    size_t& span(const unsigned node, const unsigned lvl) { return width[size_t(node) * levels + lvl]; }
+    size_t span(const unsigned node, const unsigned lvl) const { return width[size_t(node) * levels + lvl]; }
+
+    // Geometric height with p = 1/2 (xorshift64 bits), capped at the number of levels.
+    unsigned randomHeight()
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        unsigned d = 1;
+        for (uint64_t bits = seed; (bits & 1) && d < levels; bits >>= 1)
+            d++;
+
+        return d;
+    }
+};
+
+// Median and quantiles of the last N samples.
+class RollingQuantiles
+{
+public:
+    explicit RollingQuantiles(const size_t window) : ring(window), sorted(std::max<size_t>(window, 1)) { }
+
+    // A NAN sample takes its place in the window but is left out of the quantiles (na.rm = TRUE).
+    void push(const double x)
+    {
+        double old;
+
+        if (ring.push(x, old) && !isnan(old))
+            sorted.erase(old);
+        if (!isnan(x))
+            sorted.insert(x);
+    }
+
+    size_t count() const { return ring.size(); }
+
+    // Quantile of the window's non-NAN samples, type 7 (R default) interpolation.
+    double quantile(const double p) const
+    {
+        size_t n = sorted.size();
+
+        if (n == 0 || p < 0. || p > 1.)
+            return NAN;
+
+        double h = (n - 1) * p;
+        size_t lo = size_t(floor(h));
+        double g = h - lo;
+
+        return (g == 0. || lo + 1 >= n) ? sorted[lo] : (1. - g) * sorted[lo] + g * sorted[lo + 1];
+    }
+
+    // Middle value (average of the two middle values for an even count).
+    double median() const { return quantile(0.5); }
+
+private:
+    RingBuffer<double> ring;
+    IndexableSkipList sorted;
+};
+
+// Least squares line and correlation of the last N pairs (Bivariate push/remove).
+class RollingRegression
+{
+public:
+    explicit RollingRegression(const size_t window) : ring(window) { }
+
+    void push(const double x, const double y)
+    {
+        std::pair<double, double> old;
+
+        if (ring.push(std::make_pair(x, y), old))
+        {
+            moments.remove(old.first, old.second);
+
+            // Rebuild once per N evictions, as RollingStats does.
+            if (++evictions == ring.capacity())
+            {
+                moments = Bivariate();
+                for (size_t i = 0; i + 1 < ring.size(); i++)
+                    moments.push(ring[i].first, ring[i].second);
+                evictions = 0;
+            }
+        }
+        moments.push(x, y);
+    }
+
+    size_t count() const { return ring.size(); }
+    double slope() const { return moments.slope(); }
+    double intercept() const { return moments.intercept(); }
+    double r() const { return moments.r(); }
+    // Every other statistic of the window (standard errors, p-value, ...).
+    const Bivariate& fit() const { return moments; }
+
+private:
+    RingBuffer<std::pair<double, double>> ring;
+    Bivariate moments;
+    size_t evictions = 0;
+};
+
+#endif
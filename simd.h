@@ -0,0 +1,672 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+/*
+  Vectorized reduction kernels
+  Sum, centered sums of squares, centered cross products (optionally weighted), dot products and
+  min/max over contiguous double data.
+  SSE2, AVX2 and AVX-512 versions are built into every binary and one is selected at run time
+  from cpuid; other targets use the scalar kernels. Every kernel keeps several independent
+  accumulators so the additions do not form one serial dependency chain.
+  Tolerance:
+     The vector kernels add in a different order than the scalar ones. Each sum agrees with
+     the scalar result within n * DBL_EPSILON * (sum of |terms|), and in practice is usually
+     closer to the exact sum because of the shorter addition chains.
+  Usage:
+     simdSum(x, n)
+     simdSumSquares(x, n, c, s1, s2)        s1 = sum(x - c), s2 = sum((x - c)^2)
+     simdCrossSums(x, y, n, cx, cy, s)      s = { sum(dx), sum(dy), sum(dx*dx), sum(dx*dy), sum(dy*dy) }, dx = x - cx, dy = y - cy
+     simdMinMax(x, n, lo, hi)
+     simdWeightedSums(x, w, n, c, s)        s = { sum(w), sum(w*w), sum(w*d), sum(w*d*d) }, d = x - c
+     simdWeightedCrossSums(x, y, w, n, cx, cy, s)  s = { sum(w), sum(w*dx), sum(w*dy), sum(w*dx*dx), sum(w*dx*dy), sum(w*dy*dy) }
+     simdDot4(x, y, n, s)                   s[k] = sum(x * y[k]) for four vectors y[0..3] sharing the loads of x
+     setSimdLevel(level)                    force a kernel set, e.g. Scalar to compare results
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+// Kernels that mirror a scalar function are compiled between these, so that GCC does not contract
+// their multiplies and adds into FMAs (AVX-512 implies FMA) and round differently from the scalar code.
+#if defined(__GNUC__) && !defined(__clang__)
+#define SIMD_NO_CONTRACT_BEGIN _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define SIMD_NO_CONTRACT_END _Pragma("GCC pop_options")
+#else
+#define SIMD_NO_CONTRACT_BEGIN
+#define SIMD_NO_CONTRACT_END
+#endif
+#endif
+
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+static double sum_Scalar(const double* x, size_t n)
+{
+    double a0 = 0., a1 = 0., a2 = 0., a3 = 0.;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        a0 += x[i];
+        a1 += x[i + 1];
+        a2 += x[i + 2];
+        a3 += x[i + 3];
+    }
+    for (; i < n; i++)
+        a0 += x[i];
+
+    return (a0 + a1) + (a2 + a3);
+}
+
+static void sumSquares_Scalar(const double* x, size_t n, double c, double* s1, double* s2)
+{
+    double a0 = 0., a1 = 0., b0 = 0., b1 = 0.;
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        double d0 = x[i] - c, d1 = x[i + 1] - c;
+        a0 += d0;
+        a1 += d1;
+        b0 += d0 * d0;
+        b1 += d1 * d1;
+    }
+    for (; i < n; i++)
+    {
+        double d = x[i] - c;
+        a0 += d;
+        b0 += d * d;
+    }
+
+    *s1 = a0 + a1;
+    *s2 = b0 + b1;
+}
+
+static void crossSums_Scalar(const double* x, const double* y, size_t n, double cx, double cy, double* s)
+{
+    double sx = 0., sy = 0., sxx = 0., sxy = 0., syy = 0.;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double dx = x[i] - cx, dy = y[i] - cy;
+        sx += dx;
+        sy += dy;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+
+    s[0] = sx;
+    s[1] = sy;
+    s[2] = sxx;
+    s[3] = sxy;
+    s[4] = syy;
+}
+
+static void weightedSums_Scalar(const double* x, const double* w, size_t n, double c, double* s)
+{
+    double sw = 0., sww = 0., swd = 0., swdd = 0.;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double d = x[i] - c;
+        sw += w[i];
+        sww += w[i] * w[i];
+        swd += w[i] * d;
+        swdd += w[i] * d * d;
+    }
+
+    s[0] = sw;
+    s[1] = sww;
+    s[2] = swd;
+    s[3] = swdd;
+}
+
+static void weightedCrossSums_Scalar(const double* x, const double* y, const double* w, size_t n, double cx, double cy, double* s)
+{
+    double sw = 0., sx = 0., sy = 0., sxx = 0., sxy = 0., syy = 0.;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double dx = x[i] - cx, dy = y[i] - cy;
+        sw += w[i];
+        sx += w[i] * dx;
+        sy += w[i] * dy;
+        sxx += w[i] * dx * dx;
+        sxy += w[i] * dx * dy;
+        syy += w[i] * dy * dy;
+    }
+
+    s[0] = sw;
+    s[1] = sx;
+    s[2] = sy;
+    s[3] = sxx;
+    s[4] = sxy;
+    s[5] = syy;
+}
+
+static void dot4_Scalar(const double* x, const double* const* y, size_t n, double* s)
+{
+    double a0 = 0., a1 = 0., a2 = 0., a3 = 0.;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        a0 += x[i] * y[0][i];
+        a1 += x[i] * y[1][i];
+        a2 += x[i] * y[2][i];
+        a3 += x[i] * y[3][i];
+    }
+
+    s[0] = a0;
+    s[1] = a1;
+    s[2] = a2;
+    s[3] = a3;
+}
+
+static void minMax_Scalar(const double* x, size_t n, double* lo, double* hi)
+{
+    double l = x[0], h = x[0];
+
+    for (size_t i = 1; i < n; i++)
+    {
+        l = (x[i] < l) ? x[i] : l;
+        h = (x[i] > h) ? x[i] : h;
+    }
+
+    *lo = l;
+    *hi = h;
+}
+
+#ifdef SIMD_X86
+
+// Vector operations of each instruction set, suffixed with the set so that other headers can
+// generate their own kernels for every set from one macro body (see SIMD_KERNELS):
+//   V vector, W lanes, VM lane mask, VI 64-bit integer lanes,
+//   V_LOAD/V_STORE unaligned, V_SET1 broadcast, V_LT/V_LE/V_ISNAN lane masks,
+//   V_BLEND(m, a, b) = m ? b : a per lane, V_ANY(m) any lane set,
+//   V_ASINT/V_ASDBL reinterpret the bits, I_* integer lane operations.
+#define V_SSE2 __m128d
+#define W_SSE2 2
+#define VM_SSE2 __m128d
+#define VI_SSE2 __m128i
+#define V_LOAD_SSE2 _mm_loadu_pd
+#define V_STORE_SSE2 _mm_storeu_pd
+#define V_SET1_SSE2 _mm_set1_pd
+#define V_ZERO_SSE2 _mm_setzero_pd
+#define V_ADD_SSE2 _mm_add_pd
+#define V_SUB_SSE2 _mm_sub_pd
+#define V_MUL_SSE2 _mm_mul_pd
+#define V_DIV_SSE2 _mm_div_pd
+#define V_SQRT_SSE2 _mm_sqrt_pd
+#define V_MIN_SSE2 _mm_min_pd
+#define V_MAX_SSE2 _mm_max_pd
+#define V_ABS_SSE2(a) _mm_andnot_pd(_mm_set1_pd(-0.), a)
+#define V_LT_SSE2 _mm_cmplt_pd
+#define V_LE_SSE2 _mm_cmple_pd
+#define V_ISNAN_SSE2(a) _mm_cmpunord_pd(a, a)
+#define V_BLEND_SSE2(m, a, b) _mm_or_pd(_mm_and_pd(m, b), _mm_andnot_pd(m, a))
+#define V_ANY_SSE2(m) (_mm_movemask_pd(m) != 0)
+#define V_ASINT_SSE2 _mm_castpd_si128
+#define V_ASDBL_SSE2 _mm_castsi128_pd
+#define I_SET1_SSE2(c) _mm_set1_epi64x((long long)(c))
+#define I_ADD_SSE2 _mm_add_epi64
+#define I_AND_SSE2 _mm_and_si128
+#define I_OR_SSE2 _mm_or_si128
+#define I_SHL_SSE2 _mm_slli_epi64
+#define I_SHR_SSE2 _mm_srli_epi64
+
+#define V_AVX2 __m256d
+#define W_AVX2 4
+#define VM_AVX2 __m256d
+#define VI_AVX2 __m256i
+#define V_LOAD_AVX2 _mm256_loadu_pd
+#define V_STORE_AVX2 _mm256_storeu_pd
+#define V_SET1_AVX2 _mm256_set1_pd
+#define V_ZERO_AVX2 _mm256_setzero_pd
+#define V_ADD_AVX2 _mm256_add_pd
+#define V_SUB_AVX2 _mm256_sub_pd
+#define V_MUL_AVX2 _mm256_mul_pd
+#define V_DIV_AVX2 _mm256_div_pd
+#define V_SQRT_AVX2 _mm256_sqrt_pd
+#define V_MIN_AVX2 _mm256_min_pd
+#define V_MAX_AVX2 _mm256_max_pd
+#define V_ABS_AVX2(a) _mm256_andnot_pd(_mm256_set1_pd(-0.), a)
+#define V_LT_AVX2(a, b) _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define V_LE_AVX2(a, b) _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+#define V_ISNAN_AVX2(a) _mm256_cmp_pd(a, a, _CMP_UNORD_Q)
+#define V_BLEND_AVX2(m, a, b) _mm256_blendv_pd(a, b, m)
+#define V_ANY_AVX2(m) (_mm256_movemask_pd(m) != 0)
+#define V_ASINT_AVX2 _mm256_castpd_si256
+#define V_ASDBL_AVX2 _mm256_castsi256_pd
+#define I_SET1_AVX2(c) _mm256_set1_epi64x((long long)(c))
+#define I_ADD_AVX2 _mm256_add_epi64
+#define I_AND_AVX2 _mm256_and_si256
+#define I_OR_AVX2 _mm256_or_si256
+#define I_SHL_AVX2 _mm256_slli_epi64
+#define I_SHR_AVX2 _mm256_srli_epi64
+
+#define V_AVX512 __m512d
+#define W_AVX512 8
+#define VM_AVX512 __mmask8
+#define VI_AVX512 __m512i
+#define V_LOAD_AVX512 _mm512_loadu_pd
+#define V_STORE_AVX512 _mm512_storeu_pd
+#define V_SET1_AVX512 _mm512_set1_pd
+#define V_ZERO_AVX512 _mm512_setzero_pd
+#define V_ADD_AVX512 _mm512_add_pd
+#define V_SUB_AVX512 _mm512_sub_pd
+#define V_MUL_AVX512 _mm512_mul_pd
+#define V_DIV_AVX512 _mm512_div_pd
+// Masked forms, the unmasked ones start from an undefined register (spurious -Wmaybe-uninitialized).
+#define V_SQRT_AVX512(a) _mm512_mask_sqrt_pd(a, 0xff, a)
+#define V_MIN_AVX512(a, b) _mm512_mask_min_pd(a, 0xff, a, b)
+#define V_MAX_AVX512(a, b) _mm512_mask_max_pd(a, 0xff, a, b)
+#define V_ABS_AVX512 _mm512_abs_pd
+#define V_LT_AVX512(a, b) _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)
+#define V_LE_AVX512(a, b) _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ)
+#define V_ISNAN_AVX512(a) _mm512_cmp_pd_mask(a, a, _CMP_UNORD_Q)
+#define V_BLEND_AVX512(m, a, b) _mm512_mask_blend_pd(m, a, b)
+#define V_ANY_AVX512(m) ((m) != 0)
+#define V_ASINT_AVX512 _mm512_castpd_si512
+#define V_ASDBL_AVX512 _mm512_castsi512_pd
+#define I_SET1_AVX512(c) _mm512_set1_epi64((long long)(c))
+#define I_ADD_AVX512 _mm512_add_epi64
+#define I_AND_AVX512 _mm512_and_si512
+#define I_OR_AVX512 _mm512_or_si512
+#define I_SHL_AVX512(a, b) _mm512_mask_slli_epi64(a, 0xff, a, b)
+#define I_SHR_AVX512(a, b) _mm512_mask_srli_epi64(a, 0xff, a, b)
+
+// Kernel bodies shared by every instruction set, expanded once per set with the operations above.
+#define SIMD_KERNELS(ISA, TARGET)                                                                      \
+SIMD_TARGET(TARGET) static double hsum_##ISA(V_##ISA v)                                                \
+{                                                                                                      \
+    double t[W_##ISA];                                                                                 \
+    V_STORE_##ISA(t, v);                                                                               \
+    double s = 0.;                                                                                     \
+    for (int k = 0; k < W_##ISA; k++)                                                                  \
+        s += t[k];                                                                                     \
+    return s;                                                                                          \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static double sum_##ISA(const double* x, size_t n)                                 \
+{                                                                                                      \
+    V_##ISA a0 = V_ZERO_##ISA(), a1 = V_ZERO_##ISA(), a2 = V_ZERO_##ISA(), a3 = V_ZERO_##ISA();        \
+    size_t i = 0;                                                                                      \
+    for (; i + 4 * W_##ISA <= n; i += 4 * W_##ISA)                                                     \
+    {                                                                                                  \
+        a0 = V_ADD_##ISA(a0, V_LOAD_##ISA(x + i));                                                     \
+        a1 = V_ADD_##ISA(a1, V_LOAD_##ISA(x + i + W_##ISA));                                           \
+        a2 = V_ADD_##ISA(a2, V_LOAD_##ISA(x + i + 2 * W_##ISA));                                       \
+        a3 = V_ADD_##ISA(a3, V_LOAD_##ISA(x + i + 3 * W_##ISA));                                       \
+    }                                                                                                  \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+        a0 = V_ADD_##ISA(a0, V_LOAD_##ISA(x + i));                                                     \
+    double s = hsum_##ISA(V_ADD_##ISA(V_ADD_##ISA(a0, a1), V_ADD_##ISA(a2, a3)));                      \
+    for (; i < n; i++)                                                                                 \
+        s += x[i];                                                                                     \
+    return s;                                                                                          \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void sumSquares_##ISA(const double* x, size_t n, double c, double* s1, double* s2) \
+{                                                                                                      \
+    V_##ISA vc = V_SET1_##ISA(c), a0 = V_ZERO_##ISA(), a1 = V_ZERO_##ISA(), b0 = V_ZERO_##ISA(), b1 = V_ZERO_##ISA(); \
+    size_t i = 0;                                                                                      \
+    for (; i + 2 * W_##ISA <= n; i += 2 * W_##ISA)                                                     \
+    {                                                                                                  \
+        V_##ISA d0 = V_SUB_##ISA(V_LOAD_##ISA(x + i), vc), d1 = V_SUB_##ISA(V_LOAD_##ISA(x + i + W_##ISA), vc); \
+        a0 = V_ADD_##ISA(a0, d0);                                                                      \
+        a1 = V_ADD_##ISA(a1, d1);                                                                      \
+        b0 = V_ADD_##ISA(b0, V_MUL_##ISA(d0, d0));                                                     \
+        b1 = V_ADD_##ISA(b1, V_MUL_##ISA(d1, d1));                                                     \
+    }                                                                                                  \
+    double r1 = hsum_##ISA(V_ADD_##ISA(a0, a1)), r2 = hsum_##ISA(V_ADD_##ISA(b0, b1));                 \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        double d = x[i] - c;                                                                           \
+        r1 += d;                                                                                       \
+        r2 += d * d;                                                                                   \
+    }                                                                                                  \
+    *s1 = r1;                                                                                          \
+    *s2 = r2;                                                                                          \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void crossSums_##ISA(const double* x, const double* y, size_t n, double cx, double cy, double* s) \
+{                                                                                                      \
+    V_##ISA vcx = V_SET1_##ISA(cx), vcy = V_SET1_##ISA(cy);                                            \
+    V_##ISA sx = V_ZERO_##ISA(), sy = V_ZERO_##ISA(), sxx = V_ZERO_##ISA(), sxy = V_ZERO_##ISA(), syy = V_ZERO_##ISA(); \
+    size_t i = 0;                                                                                      \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+    {                                                                                                  \
+        V_##ISA dx = V_SUB_##ISA(V_LOAD_##ISA(x + i), vcx), dy = V_SUB_##ISA(V_LOAD_##ISA(y + i), vcy); \
+        sx = V_ADD_##ISA(sx, dx);                                                                      \
+        sy = V_ADD_##ISA(sy, dy);                                                                      \
+        sxx = V_ADD_##ISA(sxx, V_MUL_##ISA(dx, dx));                                                   \
+        sxy = V_ADD_##ISA(sxy, V_MUL_##ISA(dx, dy));                                                   \
+        syy = V_ADD_##ISA(syy, V_MUL_##ISA(dy, dy));                                                   \
+    }                                                                                                  \
+    s[0] = hsum_##ISA(sx);                                                                             \
+    s[1] = hsum_##ISA(sy);                                                                             \
+    s[2] = hsum_##ISA(sxx);                                                                            \
+    s[3] = hsum_##ISA(sxy);                                                                            \
+    s[4] = hsum_##ISA(syy);                                                                            \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        double dx = x[i] - cx, dy = y[i] - cy;                                                         \
+        s[0] += dx;                                                                                    \
+        s[1] += dy;                                                                                    \
+        s[2] += dx * dx;                                                                               \
+        s[3] += dx * dy;                                                                               \
+        s[4] += dy * dy;                                                                               \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void weightedSums_##ISA(const double* x, const double* w, size_t n, double c, double* s) \
+{                                                                                                      \
+    V_##ISA vc = V_SET1_##ISA(c), sw = V_ZERO_##ISA(), sww = V_ZERO_##ISA(), swd = V_ZERO_##ISA(), swdd = V_ZERO_##ISA(); \
+    size_t i = 0;                                                                                      \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+    {                                                                                                  \
+        V_##ISA vw = V_LOAD_##ISA(w + i), d = V_SUB_##ISA(V_LOAD_##ISA(x + i), vc), wd = V_MUL_##ISA(vw, d); \
+        sw = V_ADD_##ISA(sw, vw);                                                                      \
+        sww = V_ADD_##ISA(sww, V_MUL_##ISA(vw, vw));                                                   \
+        swd = V_ADD_##ISA(swd, wd);                                                                    \
+        swdd = V_ADD_##ISA(swdd, V_MUL_##ISA(wd, d));                                                  \
+    }                                                                                                  \
+    s[0] = hsum_##ISA(sw);                                                                             \
+    s[1] = hsum_##ISA(sww);                                                                            \
+    s[2] = hsum_##ISA(swd);                                                                            \
+    s[3] = hsum_##ISA(swdd);                                                                           \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        double d = x[i] - c;                                                                           \
+        s[0] += w[i];                                                                                  \
+        s[1] += w[i] * w[i];                                                                           \
+        s[2] += w[i] * d;                                                                              \
+        s[3] += w[i] * d * d;                                                                          \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void weightedCrossSums_##ISA(const double* x, const double* y, const double* w, size_t n, double cx, double cy, double* s) \
+{                                                                                                      \
+    V_##ISA vcx = V_SET1_##ISA(cx), vcy = V_SET1_##ISA(cy);                                            \
+    V_##ISA sw = V_ZERO_##ISA(), sx = V_ZERO_##ISA(), sy = V_ZERO_##ISA(), sxx = V_ZERO_##ISA(), sxy = V_ZERO_##ISA(), syy = V_ZERO_##ISA(); \
+    size_t i = 0;                                                                                      \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+    {                                                                                                  \
+        V_##ISA vw = V_LOAD_##ISA(w + i), dx = V_SUB_##ISA(V_LOAD_##ISA(x + i), vcx), dy = V_SUB_##ISA(V_LOAD_##ISA(y + i), vcy); \
+        V_##ISA wdx = V_MUL_##ISA(vw, dx), wdy = V_MUL_##ISA(vw, dy);                                  \
+        sw = V_ADD_##ISA(sw, vw);                                                                      \
+        sx = V_ADD_##ISA(sx, wdx);                                                                     \
+        sy = V_ADD_##ISA(sy, wdy);                                                                     \
+        sxx = V_ADD_##ISA(sxx, V_MUL_##ISA(wdx, dx));                                                  \
+        sxy = V_ADD_##ISA(sxy, V_MUL_##ISA(wdx, dy));                                                  \
+        syy = V_ADD_##ISA(syy, V_MUL_##ISA(wdy, dy));                                                  \
+    }                                                                                                  \
+    s[0] = hsum_##ISA(sw);                                                                             \
+    s[1] = hsum_##ISA(sx);                                                                             \
+    s[2] = hsum_##ISA(sy);                                                                             \
+    s[3] = hsum_##ISA(sxx);                                                                            \
+    s[4] = hsum_##ISA(sxy);                                                                            \
+    s[5] = hsum_##ISA(syy);                                                                            \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        double dx = x[i] - cx, dy = y[i] - cy;                                                         \
+        s[0] += w[i];                                                                                  \
+        s[1] += w[i] * dx;                                                                             \
+        s[2] += w[i] * dy;                                                                             \
+        s[3] += w[i] * dx * dx;                                                                        \
+        s[4] += w[i] * dx * dy;                                                                        \
+        s[5] += w[i] * dy * dy;                                                                        \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void dot4_##ISA(const double* x, const double* const* y, size_t n, double* s) \
+{                                                                                                      \
+    const double *y0 = y[0], *y1 = y[1], *y2 = y[2], *y3 = y[3];                                       \
+    V_##ISA a0 = V_ZERO_##ISA(), a1 = V_ZERO_##ISA(), a2 = V_ZERO_##ISA(), a3 = V_ZERO_##ISA();        \
+    size_t i = 0;                                                                                      \
+    for (; i + W_##ISA <= n; i += W_##ISA)                                                             \
+    {                                                                                                  \
+        V_##ISA vx = V_LOAD_##ISA(x + i);                                                              \
+        a0 = V_ADD_##ISA(a0, V_MUL_##ISA(vx, V_LOAD_##ISA(y0 + i)));                                   \
+        a1 = V_ADD_##ISA(a1, V_MUL_##ISA(vx, V_LOAD_##ISA(y1 + i)));                                   \
+        a2 = V_ADD_##ISA(a2, V_MUL_##ISA(vx, V_LOAD_##ISA(y2 + i)));                                   \
+        a3 = V_ADD_##ISA(a3, V_MUL_##ISA(vx, V_LOAD_##ISA(y3 + i)));                                   \
+    }                                                                                                  \
+    s[0] = hsum_##ISA(a0);                                                                             \
+    s[1] = hsum_##ISA(a1);                                                                             \
+    s[2] = hsum_##ISA(a2);                                                                             \
+    s[3] = hsum_##ISA(a3);                                                                             \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        s[0] += x[i] * y0[i];                                                                          \
+        s[1] += x[i] * y1[i];                                                                          \
+        s[2] += x[i] * y2[i];                                                                          \
+        s[3] += x[i] * y3[i];                                                                          \
+    }                                                                                                  \
+}                                                                                                      \
+                                                                                                       \
+SIMD_TARGET(TARGET) static void minMax_##ISA(const double* x, size_t n, double* lo, double* hi)        \
+{                                                                                                      \
+    size_t i = 0;                                                                                      \
+    double l = x[0], h = x[0];                                                                         \
+    if (n >= 2 * W_##ISA)                                                                              \
+    {                                                                                                  \
+        V_##ISA l0 = V_LOAD_##ISA(x), l1 = V_LOAD_##ISA(x + W_##ISA), h0 = l0, h1 = l1;                \
+        for (i = 2 * W_##ISA; i + 2 * W_##ISA <= n; i += 2 * W_##ISA)                                  \
+        {                                                                                              \
+            V_##ISA v0 = V_LOAD_##ISA(x + i), v1 = V_LOAD_##ISA(x + i + W_##ISA);                      \
+            l0 = V_MIN_##ISA(l0, v0);                                                                  \
+            l1 = V_MIN_##ISA(l1, v1);                                                                  \
+            h0 = V_MAX_##ISA(h0, v0);                                                                  \
+            h1 = V_MAX_##ISA(h1, v1);                                                                  \
+        }                                                                                              \
+        double tl[W_##ISA], th[W_##ISA];                                                               \
+        V_STORE_##ISA(tl, V_MIN_##ISA(l0, l1));                                                        \
+        V_STORE_##ISA(th, V_MAX_##ISA(h0, h1));                                                        \
+        for (int k = 0; k < W_##ISA; k++)                                                              \
+        {                                                                                              \
+            l = (tl[k] < l) ? tl[k] : l;                                                               \
+            h = (th[k] > h) ? th[k] : h;                                                               \
+        }                                                                                              \
+    }                                                                                                  \
+    for (; i < n; i++)                                                                                 \
+    {                                                                                                  \
+        l = (x[i] < l) ? x[i] : l;                                                                     \
+        h = (x[i] > h) ? x[i] : h;                                                                     \
+    }                                                                                                  \
+    *lo = l;                                                                                           \
+    *hi = h;                                                                                           \
+}                                                                                                      \
+                                                                                                       \
+/* Element-wise exp(x), within 1 ulp (fdlibm): x = k ln2 + r, |r| <= ln2 / 2, the exponent   */        \
+/* of 2^k added in the integer lanes. Results below 2^-1021 (x < -708) flush to zero.       */         \
+SIMD_TARGET(TARGET) static inline V_##ISA vexp_##ISA(V_##ISA x)                                        \
+{                                                                                                      \
+    const V_##ISA shifter = V_SET1_##ISA(6755399441055744.); /* 1.5 * 2^52, rounds k into the low bits */ \
+    V_##ISA xc = V_MIN_##ISA(V_MAX_##ISA(x, V_SET1_##ISA(-708.)), V_SET1_##ISA(709.78));               \
+    V_##ISA kd = V_ADD_##ISA(V_MUL_##ISA(xc, V_SET1_##ISA(1.44269504088896338700e+00)), shifter);      \
+    VI_##ISA k = V_ASINT_##ISA(kd);                                                                    \
+    kd = V_SUB_##ISA(kd, shifter);                                                                     \
+    V_##ISA hi = V_SUB_##ISA(xc, V_MUL_##ISA(kd, V_SET1_##ISA(6.93147180369123816490e-01)));           \
+    V_##ISA lo = V_MUL_##ISA(kd, V_SET1_##ISA(1.90821492927058770002e-10));                            \
+    V_##ISA r = V_SUB_##ISA(hi, lo), t = V_MUL_##ISA(r, r);                                            \
+    V_##ISA p = V_ADD_##ISA(V_SET1_##ISA(-1.65339022054652515390e-06), V_MUL_##ISA(t, V_SET1_##ISA(4.13813679705723846039e-08))); \
+    p = V_ADD_##ISA(V_SET1_##ISA(6.61375632143793436117e-05), V_MUL_##ISA(t, p));                      \
+    p = V_ADD_##ISA(V_SET1_##ISA(-2.77777777770155933842e-03), V_MUL_##ISA(t, p));                     \
+    p = V_ADD_##ISA(V_SET1_##ISA(1.66666666666666019037e-01), V_MUL_##ISA(t, p));                      \
+    V_##ISA c = V_SUB_##ISA(r, V_MUL_##ISA(t, p));                                                     \
+    V_##ISA y = V_DIV_##ISA(V_MUL_##ISA(r, c), V_SUB_##ISA(V_SET1_##ISA(2.), c));                      \
+    y = V_SUB_##ISA(V_SET1_##ISA(1.), V_SUB_##ISA(V_SUB_##ISA(lo, y), hi));                            \
+    y = V_ASDBL_##ISA(I_ADD_##ISA(V_ASINT_##ISA(y), I_SHL_##ISA(k, 52)));                              \
+    y = V_BLEND_##ISA(V_LT_##ISA(x, V_SET1_##ISA(-708.)), y, V_ZERO_##ISA());                          \
+    y = V_BLEND_##ISA(V_LT_##ISA(V_SET1_##ISA(709.78), x), y, V_SET1_##ISA(HUGE_VAL));                 \
+    return V_BLEND_##ISA(V_ISNAN_##ISA(x), y, x);                                                      \
+}                                                                                                      \
+                                                                                                       \
+/* Element-wise log(x) for finite x > 0, within 1 ulp (fdlibm): x = 2^k m,                 */          \
+/* sqrt(1/2) <= m < sqrt(2), f = m - 1, s = f / (2 + f), log(m) = f - f^2/2 + s (f^2/2 + R). */        \
+SIMD_TARGET(TARGET) static inline V_##ISA vlog_##ISA(V_##ISA x)                                        \
+{                                                                                                      \
+    VM_##ISA sub = V_LT_##ISA(x, V_SET1_##ISA(2.2250738585072014e-308));                               \
+    x = V_BLEND_##ISA(sub, x, V_MUL_##ISA(x, V_SET1_##ISA(18014398509481984.))); /* subnormal: scale by 2^54 */ \
+    VI_##ISA bits = V_ASINT_##ISA(x);                                                                  \
+    V_##ISA k = V_SUB_##ISA(V_ASDBL_##ISA(I_OR_##ISA(I_SHR_##ISA(bits, 52), I_SET1_##ISA(0x4330000000000000LL))), V_SET1_##ISA(4503599627371519.)); \
+    k = V_BLEND_##ISA(sub, k, V_SUB_##ISA(k, V_SET1_##ISA(54.)));                                      \
+    V_##ISA m = V_ASDBL_##ISA(I_OR_##ISA(I_AND_##ISA(bits, I_SET1_##ISA(0x000fffffffffffffLL)), I_SET1_##ISA(0x3ff0000000000000LL))); \
+    VM_##ISA big = V_LT_##ISA(V_SET1_##ISA(1.41421356237309504880), m);                                \
+    m = V_BLEND_##ISA(big, m, V_MUL_##ISA(m, V_SET1_##ISA(0.5)));                                      \
+    k = V_BLEND_##ISA(big, k, V_ADD_##ISA(k, V_SET1_##ISA(1.)));                                       \
+    V_##ISA f = V_SUB_##ISA(m, V_SET1_##ISA(1.));                                                      \
+    V_##ISA s = V_DIV_##ISA(f, V_ADD_##ISA(V_SET1_##ISA(2.), f)), z = V_MUL_##ISA(s, s);               \
+    V_##ISA R = V_ADD_##ISA(V_SET1_##ISA(1.531383769920937332e-01), V_MUL_##ISA(z, V_SET1_##ISA(1.479819860511658591e-01))); \
+    R = V_ADD_##ISA(V_SET1_##ISA(1.818357216161805012e-01), V_MUL_##ISA(z, R));                        \
+    R = V_ADD_##ISA(V_SET1_##ISA(2.222219843214978396e-01), V_MUL_##ISA(z, R));                        \
+    R = V_ADD_##ISA(V_SET1_##ISA(2.857142874366239149e-01), V_MUL_##ISA(z, R));                        \
+    R = V_ADD_##ISA(V_SET1_##ISA(3.999999999940941908e-01), V_MUL_##ISA(z, R));                        \
+    R = V_ADD_##ISA(V_SET1_##ISA(6.666666666666735130e-01), V_MUL_##ISA(z, R));                        \
+    R = V_MUL_##ISA(z, R);                                                                             \
+    V_##ISA hfsq = V_MUL_##ISA(V_SET1_##ISA(0.5), V_MUL_##ISA(f, f));                                  \
+    V_##ISA y = V_ADD_##ISA(V_MUL_##ISA(s, V_ADD_##ISA(hfsq, R)), V_MUL_##ISA(k, V_SET1_##ISA(1.90821492927058770002e-10))); \
+    return V_SUB_##ISA(V_MUL_##ISA(k, V_SET1_##ISA(6.93147180369123816490e-01)), V_SUB_##ISA(V_SUB_##ISA(hfsq, y), f)); \
+}
+
+SIMD_NO_CONTRACT_BEGIN
+SIMD_KERNELS(SSE2, "sse2")
+SIMD_KERNELS(AVX2, "avx2")
+SIMD_KERNELS(AVX512, "avx512f")
+SIMD_NO_CONTRACT_END
+
+#undef SIMD_KERNELS
+
+// Highest instruction set supported by both the CPU and the operating system (saved vector state).
+static SimdLevel detectSimdLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+
+    __cpuid(r, 0);
+    int leaves = r[0];
+
+    __cpuid(r, 1);
+    bool sse2 = (r[3] & (1 << 26)) != 0;
+    bool osxsave = (r[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+
+    bool avx2 = false, avx512 = false;
+    if (leaves >= 7)
+    {
+        __cpuidex(r, 7, 0);
+        avx2 = (r[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        avx512 = (r[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+    }
+
+    return avx512 ? SimdLevel::AVX512 : avx2 ? SimdLevel::AVX2 : sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#else
+    // Reads cpuid and the OS-enabled state once at startup.
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+
+    return SimdLevel::Scalar;
+#endif
+}
+
+#else
+
+static SimdLevel detectSimdLevel() { return SimdLevel::Scalar; }
+
+#endif
+
+// Kernel set in use.
+struct SimdKernels
+{
+    SimdLevel level;
+    double (*sum)(const double*, size_t);
+    void (*sumSquares)(const double*, size_t, double, double*, double*);
+    void (*crossSums)(const double*, const double*, size_t, double, double, double*);
+    void (*minMax)(const double*, size_t, double*, double*);
+    void (*weightedSums)(const double*, const double*, size_t, double, double*);
+    void (*weightedCrossSums)(const double*, const double*, const double*, size_t, double, double, double*);
+    void (*dot4)(const double*, const double* const*, size_t, double*);
+};
+
+static SimdKernels simdKernelsFor(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef SIMD_X86
+    case SimdLevel::AVX512: return { level, sum_AVX512, sumSquares_AVX512, crossSums_AVX512, minMax_AVX512, weightedSums_AVX512, weightedCrossSums_AVX512, dot4_AVX512 };
+    case SimdLevel::AVX2: return { level, sum_AVX2, sumSquares_AVX2, crossSums_AVX2, minMax_AVX2, weightedSums_AVX2, weightedCrossSums_AVX2, dot4_AVX2 };
+    case SimdLevel::SSE2: return { level, sum_SSE2, sumSquares_SSE2, crossSums_SSE2, minMax_SSE2, weightedSums_SSE2, weightedCrossSums_SSE2, dot4_SSE2 };
+#endif
+    default: return { SimdLevel::Scalar, sum_Scalar, sumSquares_Scalar, crossSums_Scalar, minMax_Scalar, weightedSums_Scalar, weightedCrossSums_Scalar, dot4_Scalar };
+    }
+}
+
+static SimdKernels& simdKernels()
+{
+    static SimdKernels kernels = simdKernelsFor(detectSimdLevel());
+    return kernels;
+}
+
+SimdLevel simdLevel() { return simdKernels().level; }
+
+// Select a kernel set, capped at what the host supports.
+void setSimdLevel(const SimdLevel level)
+{
+    SimdLevel supported = detectSimdLevel();
+    simdKernels() = simdKernelsFor((int(level) < int(supported)) ? level : supported);
+}
+
+double simdSum(const double* x, const size_t n)
+{
+    return simdKernels().sum(x, n);
+}
+
+void simdSumSquares(const double* x, const size_t n, const double c, double& s1, double& s2)
+{
+    simdKernels().sumSquares(x, n, c, &s1, &s2);
+}
+
+void simdCrossSums(const double* x, const double* y, const size_t n, const double cx, const double cy, double s[5])
+{
+    simdKernels().crossSums(x, y, n, cx, cy, s);
+}
+
+void simdWeightedSums(const double* x, const double* w, const size_t n, const double c, double s[4])
+{
+    simdKernels().weightedSums(x, w, n, c, s);
+}
+
+void simdWeightedCrossSums(const double* x, const double* y, const double* w, const size_t n, const double cx, const double cy, double s[6])
+{
+    simdKernels().weightedCrossSums(x, y, w, n, cx, cy, s);
+}
+
+void simdDot4(const double* x, const double* const y[4], const size_t n, double s[4])
+{
+    simdKernels().dot4(x, y, n, s);
+}
+
+// Requires n > 0.
+void simdMinMax(const double* x, const size_t n, double& lo, double& hi)
+{
+    simdKernels().minMax(x, n, &lo, &hi);
+}
+
+#endif
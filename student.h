@@ -93,11 +93,15 @@ double pt(double x, unsigned int n)
 // Hill, G. W. (1970).
 // Algorithm 396: Student's t-quantiles.
 // Communications of the ACM, 13(10), 619-620.
-double qt(double p, unsigned int n) 
+// In a constant expression the quantile is solved to full precision (critical.h).
+constexpr double qt(double p, unsigned int n) 
 {
     assert(p >= 0 && p <= 1);
     assert(n >= 1);
 
+    if (std::is_constant_evaluated())
+        return cxQt(p, n);
+
     // distribution is symmetric.
     double sign = p < 0.5 ? -1 : 1;
     p = p < 0.5 ? 1 - p : p;
@@ -0,0 +1,179 @@
+#ifndef WEIGHTED_H
+#define WEIGHTED_H
+
+#include "common.h"
+
+/*
+  Weighted descriptive statistics
+  Statistics of (value, weight) data without expanding it back into raw observations.
+  Sums run on the SIMD kernels in cache-sized chunks across the thread pool, like the
+  unweighted versions; weighted quantiles sort the (value, weight) pairs with parallelSort.
+     Frequency weights: w[i] is how many times x[i] was observed, variance divides by sum(w) - 1
+       (identical to variance() of the expanded data).
+     Reliability weights: w[i] is the relative precision of x[i], variance divides by
+       sum(w) - sum(w^2) / sum(w) (unbiased, independent of the scale of w).
+  Usage:
+     weightedMean(x, w)
+     weightedVariance(x, w, type = WeightType::Frequency)
+     weightedStandardDeviation(x, w, type = WeightType::Frequency)
+     weightedMedian(x, w)
+     weightedQuantiles(x, w, probs)
+     lsq(x, y, w)   weighted least squares, returns std::pair(m, b)
+*/
+
+enum class WeightType { Frequency, Reliability };
+
+// Total weight, sum of squared weights, weighted mean and weighted sum of squared deviations.
+struct WeightedMoments
+{
+    double w = 0., w2 = 0., mean = 0., m2 = 0.;
+};
+
+static WeightedMoments mergeWeightedMoments(const WeightedMoments& a, const WeightedMoments& b)
+{
+    if (a.w == 0.)
+        return b;
+    if (b.w == 0.)
+        return a;
+
+    WeightedMoments r;
+    double d = b.mean - a.mean;
+
+    r.w = a.w + b.w;
+    r.w2 = a.w2 + b.w2;
+    r.mean = a.mean + d * b.w / r.w;
+    r.m2 = a.m2 + b.m2 + d * d * a.w * b.w / r.w;
+
+    return r;
+}
+
+static WeightedMoments weightedMoments(const std::vector<double>& x, const std::vector<double>& w)
+{
+    assert(x.size() == w.size());
+
+    auto chunk = [&x, &w](size_t begin, size_t end)
+    {
+        WeightedMoments c;
+        size_t m = end - begin;
+        double s[4];
+
+        // Weighted mean, then sums centered on it while the chunk is in cache.
+        simdWeightedSums(x.data() + begin, w.data() + begin, m, 0., s);
+        if (s[0] == 0.)
+            return c;
+
+        double mu = s[2] / s[0];
+        simdWeightedSums(x.data() + begin, w.data() + begin, m, mu, s);
+
+        c.w = s[0];
+        c.w2 = s[1];
+        c.mean = mu + s[2] / s[0];
+        c.m2 = s[3] - s[2] * s[2] / s[0];
+
+        return c;
+    };
+
+    return parallelReduce<WeightedMoments>(x.size(), chunk, mergeWeightedMoments);
+}
+
+double weightedMean(const std::vector<double>& x, const std::vector<double>& w)
+{
+    WeightedMoments m = weightedMoments(x, w);
+
+    return (m.w == 0.) ? NAN : m.mean;
+}
+
+double weightedVariance(const std::vector<double>& x, const std::vector<double>& w, const WeightType type = WeightType::Frequency)
+{
+    WeightedMoments m = weightedMoments(x, w);
+
+    if (type == WeightType::Reliability)
+        return m.m2 / (m.w - m.w2 / m.w);
+
+    return m.m2 / (m.w - 1.);
+}
+
+double weightedStandardDeviation(const std::vector<double>& x, const std::vector<double>& w, const WeightType type = WeightType::Frequency)
+{
+    return sqrt(weightedVariance(x, w, type));
+}
+
+// Weighted quantiles: the smallest x whose cumulative weight reaches p * sum(w), averaged with
+// the next value when it is reached exactly. With frequency weights this equals type 2 quantiles
+// of the expanded data. Zero weights are ignored.
+std::vector<double> weightedQuantiles(const std::vector<double>& x, const std::vector<double>& w, const std::vector<double>& probs)
+{
+    assert(x.size() == w.size());
+
+    std::vector<double> q(probs.size(), NAN);
+    std::vector<std::pair<double, double>> xw;
+
+    xw.reserve(x.size());
+    for (size_t i = 0; i < x.size(); i++)
+        if (w[i] > 0.)
+            xw.emplace_back(x[i], w[i]);
+
+    if (xw.empty())
+        return q;
+
+    parallelSort(xw.begin(), xw.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.first < b.first; });
+
+    std::vector<double> cum(xw.size());
+    double total = 0.;
+    for (size_t i = 0; i < xw.size(); i++)
+        cum[i] = (total += xw[i].second);
+
+    const double fuzz = 4 * DBL_EPSILON * total;
+    for (size_t k = 0; k < probs.size(); k++)
+    {
+        if (isnan(probs[k]) || probs[k] < 0. || probs[k] > 1.)
+            continue;
+
+        double target = probs[k] * total;
+        size_t i = size_t(std::lower_bound(cum.begin(), cum.end(), target - fuzz) - cum.begin());
+
+        if (i >= xw.size())
+            i = xw.size() - 1;
+
+        if (fabs(cum[i] - target) <= fuzz && i + 1 < xw.size() && probs[k] > 0.)
+            q[k] = (xw[i].first + xw[i + 1].first) / 2.;
+        else
+            q[k] = xw[i].first;
+    }
+
+    return q;
+}
+
+double weightedMedian(const std::vector<double>& x, const std::vector<double>& w)
+{
+    return weightedQuantiles(x, w, { 0.5 })[0];
+}
+
+// Weighted least squares fit of y = mx + b, minimizing sum(w * (y - mx - b)^2). Returns std::pair(m, b)
+std::pair<double, double> lsq(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& w)
+{
+    assert(x.size() == y.size() && x.size() == w.size());
+
+    // Per chunk weighted means then centered cross sums, merged as a Bivariate with n = total weight.
+    auto chunk = [&x, &y, &w](size_t begin, size_t end)
+    {
+        size_t m = end - begin;
+        double s[6];
+
+        simdWeightedCrossSums(x.data() + begin, y.data() + begin, w.data() + begin, m, 0., 0., s);
+        if (s[0] == 0.)
+            return Bivariate();
+
+        double mx = s[1] / s[0], my = s[2] / s[0];
+        simdWeightedCrossSums(x.data() + begin, y.data() + begin, w.data() + begin, m, mx, my, s);
+
+        return Bivariate(s[0], mx + s[1] / s[0], my + s[2] / s[0], s[3] - s[1] * s[1] / s[0], s[4] - s[1] * s[2] / s[0], s[5] - s[2] * s[2] / s[0]);
+    };
+    auto combine = [](Bivariate a, const Bivariate& b) { a.merge(b); return a; };
+
+    Bivariate fit = parallelReduce<Bivariate>(x.size(), chunk, combine);
+
+    return std::make_pair(fit.slope(), fit.intercept());
+}
+
+#endif